@@ -0,0 +1,599 @@
+#include "include/configuration.hpp"
+
+#include <sstream>
+
+// Command line options for the benchmarks
+struct BenchmarkOptions {
+	std::vector<int64_t> populations = {1000, NUM_BIRDS, 20000}; // Population sizes to test
+	std::vector<int64_t> threads	 = {1, numThreads};			 // Thread counts to test
+	double minTime					 = 0.2; // Minimum seconds to run each benchmark for
+	std::string filter;						// Only run benchmarks whose names contain this
+	std::string format = "csv";				// Output format (csv or json)
+	std::string output;						// File to write the results to (empty = stdout)
+
+	// Generations to train with each activation function instead of benchmarking (0 = benchmark)
+	int64_t parity = 0;
+
+	// Generations to train with each decision interval instead of benchmarking (0 = benchmark)
+	int64_t decisions = 0;
+};
+
+// The result of running one benchmark with one population size and thread count
+struct BenchmarkResult {
+	std::string name;
+	std::string unit;	// What a single operation is (a brain, a bird, a tick, ...)
+	int64_t population; // Number of birds (or brains)
+	int64_t threads;	// Number of threads used
+	int64_t iterations; // Number of times the benchmark's body was run
+	int64_t operations; // Operations performed by each iteration
+	double seconds;		// Total time spent running the body
+
+	[[nodiscard]] double nanosecondsPerOperation() const {
+		return seconds * 1e9 / static_cast<double>(iterations * operations);
+	}
+
+	[[nodiscard]] double operationsPerSecond() const {
+		return static_cast<double>(iterations * operations) / seconds;
+	}
+};
+
+// Stop the compiler from optimising away a computation whose result is never used
+template<typename T>
+void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static const void *volatile sink;
+	sink = &value;
+#endif
+}
+
+// Runs benchmarks and collects their results
+class BenchmarkRunner {
+public:
+	explicit BenchmarkRunner(const BenchmarkOptions &options) : m_options(options) {}
+
+	// Whether a benchmark should be run at all. Use this to skip expensive setup
+	[[nodiscard]] bool enabled(const std::string &name) const {
+		return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+	}
+
+	// Whether any of a group of benchmarks should be run
+	[[nodiscard]] bool enabled(std::initializer_list<const char *> names) const {
+		return std::any_of(
+		  names.begin(), names.end(), [this](const char *name) { return enabled(name); });
+	}
+
+	// Call `body` repeatedly for at least the minimum time and record how long it took. Each call
+	// performs `operations` operations of the given unit
+	template<typename Body>
+	void run(const std::string &name, const std::string &unit, int64_t population, int64_t threads,
+			 int64_t operations, Body &&body) {
+		if (!enabled(name)) { return; }
+
+		body(); // Warm up the caches (and allocate any buffers)
+
+		// Double the number of calls between each check of the clock, so that very fast bodies
+		// aren't dominated by the cost of reading it
+		int64_t iterations = 0;
+		int64_t batch	   = 1;
+		double start	   = librapid::now();
+		double elapsed	   = 0;
+		while (elapsed < m_options.minTime) {
+			for (int64_t i = 0; i < batch; ++i) { body(); }
+			iterations += batch;
+			batch	= std::min<int64_t>(batch * 2, 1 << 20);
+			elapsed = librapid::now() - start;
+		}
+
+		m_results.push_back({name, unit, population, threads, iterations, operations, elapsed});
+
+		// Show progress when the results aren't being written to the console
+		if (!m_options.output.empty()) {
+			fmt::print("{:<28} population {:>8} threads {:>3}: {:>12.2f} ns/{}\n",
+					   name,
+					   population,
+					   threads,
+					   m_results.back().nanosecondsPerOperation(),
+					   unit);
+		}
+	}
+
+	[[nodiscard]] const std::vector<BenchmarkResult> &results() const { return m_results; }
+
+private:
+	BenchmarkOptions m_options;
+	std::vector<BenchmarkResult> m_results;
+};
+
+// Format the results as CSV, with one row per result
+std::string formatCsv(const std::vector<BenchmarkResult> &results) {
+	std::string csv = "benchmark,unit,population,threads,iterations,operations,seconds,"
+					  "ns_per_operation,operations_per_second\n";
+	for (const auto &result : results) {
+		csv += fmt::format("{},{},{},{},{},{},{},{},{}\n",
+						   result.name,
+						   result.unit,
+						   result.population,
+						   result.threads,
+						   result.iterations,
+						   result.operations,
+						   result.seconds,
+						   result.nanosecondsPerOperation(),
+						   result.operationsPerSecond());
+	}
+	return csv;
+}
+
+// Format the results as a JSON array, with one object per result
+std::string formatJson(const std::vector<BenchmarkResult> &results) {
+	std::string json = "[\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto &result = results[i];
+		json += fmt::format("  {{\"benchmark\": \"{}\", \"unit\": \"{}\", \"population\": {}, "
+							"\"threads\": {}, \"iterations\": {}, \"operations\": {}, "
+							"\"seconds\": {}, \"ns_per_operation\": {}, "
+							"\"operations_per_second\": {}}}{}\n",
+							result.name,
+							result.unit,
+							result.population,
+							result.threads,
+							result.iterations,
+							result.operations,
+							result.seconds,
+							result.nanosecondsPerOperation(),
+							result.operationsPerSecond(),
+							i + 1 < results.size() ? "," : "");
+	}
+	return json + "]\n";
+}
+
+// Create a Brain (the librapid implementation) with the same topology as BirdBrain
+Brain<Scalar, Backend> createGenericBrain(Random &random) {
+	Brain<Scalar, Backend> brain;
+	for (size_t nodes : BirdBrain().topology()) { brain << nodes; }
+	brain.construct(random);
+	return brain;
+}
+
+// Benchmarks for a single brain at a time, run over a whole population of brains so that the
+// memory access pattern matches the simulation
+void benchmarkBrains(BenchmarkRunner &runner, int64_t population) {
+	Random random(RANDOM_SEED);
+
+	if (runner.enabled({"brain_forward", "brain_copy", "brain_mutate"})) {
+		std::vector<Brain<Scalar, Backend>> brains;
+		for (int64_t i = 0; i < population; ++i) { brains.push_back(createGenericBrain(random)); }
+
+		auto inputs = Brain<Scalar, Backend>::Array(librapid::Shape({BirdBrain::numInputs}));
+		for (auto &input : inputs.storage()) { input = random.uniform(-1, 1); }
+
+		runner.run("brain_forward", "brain", population, 1, population, [&]() {
+			for (auto &brain : brains) { doNotOptimize(brain.forward(inputs)); }
+		});
+
+		runner.run("brain_copy", "brain", population, 1, population, [&]() {
+			for (const auto &brain : brains) { doNotOptimize(brain.copy()); }
+		});
+
+		runner.run("brain_mutate", "brain", population, 1, population, [&]() {
+			for (auto &brain : brains) { brain.mutate(mutationRate, random); }
+		});
+	}
+
+	if (runner.enabled({"static_brain_forward", "static_brain_copy", "static_brain_mutate"})) {
+		std::vector<BirdBrain> brains(population);
+		for (auto &brain : brains) { brain.construct(random); }
+
+		BirdBrain::Input inputs;
+		for (auto &input : inputs) { input = random.uniform(-1, 1); }
+
+		runner.run("static_brain_forward", "brain", population, 1, population, [&]() {
+			for (const auto &brain : brains) { doNotOptimize(brain.forward(inputs)); }
+		});
+
+		runner.run("static_brain_copy", "brain", population, 1, population, [&]() {
+			for (const auto &brain : brains) { doNotOptimize(brain.copy()); }
+		});
+
+		runner.run("static_brain_mutate", "brain", population, 1, population, [&]() {
+			for (auto &brain : brains) { brain.mutate(mutationRate, random); }
+		});
+	}
+}
+
+// Benchmarks for choosing parents. Each iteration prepares the selector and chooses a parent for
+// every child, which is exactly the work done once per generation
+void benchmarkSelection(BenchmarkRunner &runner, int64_t population) {
+	Random random(RANDOM_SEED);
+	std::vector<double> fitness(population);
+	for (auto &value : fitness) { value = std::pow(random.uniform(0, 1000), 2); }
+
+	const std::pair<const char *, SelectionStrategy> strategies[] = {
+	  {"selection_roulette", SelectionStrategy::Roulette},
+	  {"selection_tournament", SelectionStrategy::Tournament},
+	  {"selection_rank", SelectionStrategy::Rank}};
+
+	for (const auto &[name, strategy] : strategies) {
+		ParentSelector selector(strategy);
+		runner.run(name, "child", population, 1, population, [&]() {
+			selector.prepare(fitness);
+			int64_t sum = 0;
+			for (int64_t i = 0; i < population; ++i) { sum += selector.select(random); }
+			doNotOptimize(sum);
+		});
+	}
+}
+
+// Benchmarks for the world: walls, sensor inputs and collisions
+void benchmarkWorld(BenchmarkRunner &runner, int64_t population) {
+	const WorldBounds bounds {WORLD_WIDTH, WORLD_HEIGHT};
+	Random random(RANDOM_SEED);
+
+	Course course(RANDOM_SEED);
+	WallRing walls(NUM_WALLS);
+	resetWalls(walls, bounds, course);
+
+	BirdPopulation birds = createBirds(population, bounds);
+	for (int64_t i = 0; i < population; ++i) {
+		birds.y(i)		  = random.uniform(0, bounds.height - BIRD_SIZE);
+		birds.velocity(i) = random.uniform(-5, 5);
+	}
+
+	WorldQuery query = queryWorld(birds, walls, bounds);
+	std::vector<Scalar> inputs(population * BirdBrain::numInputs);
+
+	runner.run("query_world", "tick", population, 1, 1, [&]() {
+		doNotOptimize(queryWorld(birds, walls, bounds));
+	});
+
+	runner.run("generate_bird_inputs", "bird", population, 1, population, [&]() {
+		for (int64_t i = 0; i < population; ++i) {
+			generateBirdInputs(birds, i, query, bounds, inputs.data() + i * BirdBrain::numInputs);
+		}
+		doNotOptimize(inputs);
+	});
+
+	// The old per-bird collision test, against both halves of every wall
+	runner.run("rect_intersection", "bird", population, 1, population, [&]() {
+		int64_t hits = 0;
+		for (int64_t i = 0; i < population; ++i) {
+			for (int64_t j = 0; j < walls.size(); ++j) {
+				auto [upper, lower] = walls[j].rectangles(bounds.height);
+				hits += rectIntersection(birds.rectangle(i), upper) ||
+						rectIntersection(birds.rectangle(i), lower);
+			}
+		}
+		doNotOptimize(hits);
+	});
+
+	// The physics step, which includes the collision test against the world query. The bounds
+	// are infinite so that no birds die, and every iteration does the same amount of work
+	runner.run("bird_step", "bird", population, 1, population, [&]() {
+		doNotOptimize(birds.step(0, population, 0, -DBL_MAX, DBL_MAX, 0));
+	});
+
+	runner.run("update_walls", "tick", population, 1, 1, [&]() {
+		updateWalls(walls, bounds, course);
+		doNotOptimize(walls);
+	});
+}
+
+// Benchmarks for the parts of the simulation that are split across threads
+void benchmarkThreaded(BenchmarkRunner &runner, int64_t population, int64_t threads) {
+	const WorldBounds bounds {WORLD_WIDTH, WORLD_HEIGHT};
+	ThreadPool pool(threads);
+	std::vector<Random> randoms = createRandomStreams(RANDOM_SEED, pool.size());
+
+	GenomeArena<Gene> genomes(population, BirdBrain().topology());
+	for (int64_t i = 0; i < population; ++i) { genomes.store(i, createBirdBrain(randoms[0])); }
+
+	std::vector<double> fitness(population);
+	for (auto &value : fitness) { value = std::pow(randoms[0].uniform(0, 1000), 2); }
+
+	PopulationBrain<Scalar> brains(BirdBrain().topology(), population);
+	for (int64_t i = 0; i < population; ++i) {
+		for (size_t j = 0; j < BirdBrain::numInputs; ++j) {
+			brains.inputs(i)[j] = randoms[0].uniform(-1, 1);
+		}
+		brains.batch()[i] = i;
+	}
+
+	auto forward = [&]() {
+		pool.parallelFor(population, [&](int64_t begin, int64_t end, int64_t) {
+			brains.forward(genomes, begin, end - begin);
+		});
+		doNotOptimize(brains.jump());
+	};
+
+	runner.run("population_brain_forward", "brain", population, threads, population, forward);
+
+	// The same, with each of the activation functions
+	for (int64_t i = 0; i < numActivations; ++i) {
+		brains.setActivation(static_cast<Activation>(i));
+		runner.run(fmt::format("population_brain_{}", activationNames[i]),
+				   "brain",
+				   population,
+				   threads,
+				   population,
+				   forward);
+	}
+	brains.setActivation(Activation::Sigmoid);
+
+	ParentSelector selector;
+	MutationEngine mutation(BirdBrain().topology());
+	runner.run("new_generation", "child", population, threads, population, [&]() {
+		newGeneration(genomes, fitness, selector, mutation, mutationRate, pool, randoms);
+	});
+
+	// Update every bird with no walls and no floor or ceiling, so that every bird stays alive and
+	// every iteration does the same amount of work
+	BirdPopulation birds = createBirds(population, bounds);
+	WorldQuery open {-DBL_MAX, DBL_MAX, 0, 0, 0};
+	runner.run("update_birds", "bird", population, threads, population, [&]() {
+		pool.parallelFor(population, [&](int64_t begin, int64_t end, int64_t) {
+			updateBirds(birds, genomes, open, bounds, 0, brains, begin, end);
+		});
+	});
+
+	// The same, but with each brain only evaluated every fourth tick. Consecutive iterations are
+	// consecutive ticks, so each one evaluates a different quarter of the birds
+	DecisionSchedule schedule = {4, 1, 0};
+	runner.run("update_birds_decision_4", "bird", population, threads, population, [&]() {
+		pool.parallelFor(population, [&](int64_t begin, int64_t end, int64_t) {
+			updateBirds(birds, genomes, open, bounds, 0, brains, begin, end, 0, schedule);
+		});
+		++schedule.tick;
+	});
+
+	// Whole ticks of the simulation, including the occasional new generation when every bird dies
+	if (runner.enabled("tick")) {
+		Simulation simulation(bounds, population, RANDOM_SEED, threads);
+		runner.run("tick", "tick", population, threads, 1, [&]() {
+			if (simulation.tick() == 0) { simulation.nextGeneration(); }
+		});
+	}
+
+	// The same, but with every genome evaluated on four courses at once
+	if (runner.enabled("tick_4_episodes")) {
+		Simulation simulation(bounds, population, RANDOM_SEED, threads, 4);
+		runner.run("tick_4_episodes", "tick", population, threads, 1, [&]() {
+			if (simulation.tick() == 0) { simulation.nextGeneration(); }
+		});
+	}
+
+	// The same, but with each brain only evaluated every fourth tick
+	if (runner.enabled("tick_decision_4")) {
+		Simulation simulation(bounds, population, RANDOM_SEED, threads);
+		simulation.setDecisionInterval(4);
+		runner.run("tick_decision_4", "tick", population, threads, 1, [&]() {
+			if (simulation.tick() == 0) { simulation.nextGeneration(); }
+		});
+	}
+}
+
+// Run a simulation until every bird has died or its tick budget has run out. Only generational
+// replacement ever gets there, since a steady-state tick() never returns 0, so steady-state
+// simulations are refused
+bool runGeneration(Simulation &simulation) {
+	if (simulation.steadyState()) {
+		fmt::print(fmt::fg(fmt::color::red),
+				   "Steady-state simulations have no generations to run to the end of\n");
+		return false;
+	}
+
+	while (simulation.tick() != 0) {}
+	return true;
+}
+
+// Compare every activation function with the exact sigmoid. The jump decisions of a population of
+// random brains show how closely each one follows the sigmoid, and training a population with the
+// same seed shows whether it learns as well. Each generation is cut short after a fixed number of
+// ticks, so a population that has learnt to fly forever still finishes
+void checkActivationParity(int64_t generations, int64_t population) {
+	static constexpr int64_t tickBudget = 20000;
+
+	const WorldBounds bounds {WORLD_WIDTH, WORLD_HEIGHT};
+	Random random(RANDOM_SEED);
+
+	GenomeArena<Gene> genomes(population, BirdBrain().topology());
+	for (int64_t i = 0; i < population; ++i) { genomes.store(i, createBirdBrain(random)); }
+
+	PopulationBrain<Scalar> brains(BirdBrain().topology(), population);
+	for (int64_t i = 0; i < population; ++i) {
+		for (size_t j = 0; j < BirdBrain::numInputs; ++j) {
+			brains.inputs(i)[j] = random.uniform(-1, 1);
+		}
+		brains.batch()[i] = i;
+	}
+
+	brains.forward(genomes, 0, population);
+	const std::vector<uint8_t> reference = brains.jump();
+
+	fmt::print("activation,decision_agreement,mean_distance,best_distance,seconds\n");
+	for (int64_t i = 0; i < numActivations; ++i) {
+		const auto activation = static_cast<Activation>(i);
+
+		brains.setActivation(activation);
+		brains.forward(genomes, 0, population);
+		int64_t agreed = 0;
+		for (int64_t j = 0; j < population; ++j) { agreed += brains.jump()[j] == reference[j]; }
+
+		Simulation simulation(bounds, population, RANDOM_SEED, numThreads);
+		simulation.setActivation(activation);
+		simulation.setTickBudget(tickBudget);
+
+		double total = 0;
+		double best	 = 0;
+		double start = librapid::now();
+		for (int64_t generation = 0; generation < generations; ++generation) {
+			if (!runGeneration(simulation)) { return; }
+			total += simulation.distance();
+			best = std::max(best, simulation.distance());
+			simulation.nextGeneration();
+		}
+
+		fmt::print("{},{},{},{},{}\n",
+				   activationNames[i],
+				   static_cast<double>(agreed) / static_cast<double>(population),
+				   total / static_cast<double>(generations),
+				   best,
+				   librapid::now() - start);
+	}
+}
+
+// Measure the cost and benefit of each decision interval and number of physics substeps, by
+// training a population with the same seed for each one. The distances show how much (if at all)
+// the birds fly worse for it. The ticks per second also depend on how long the birds survive, so
+// compare update_birds with update_birds_decision_4 for the saving at a fixed population. Like the
+// activation comparison, each generation is cut short after a fixed number of ticks
+void compareDecisionIntervals(int64_t generations, int64_t population) {
+	static constexpr int64_t tickBudget = 20000;
+
+	const WorldBounds bounds {WORLD_WIDTH, WORLD_HEIGHT};
+
+	fmt::print("decision_interval,substeps,ticks_per_second,mean_distance,best_distance,"
+			   "seconds\n");
+	for (int64_t substeps : {1, 4}) {
+		for (int64_t interval : {1, 2, 4, 8}) {
+			Simulation simulation(bounds, population, RANDOM_SEED, numThreads);
+			simulation.setDecisionInterval(interval);
+			simulation.setSubsteps(substeps);
+			simulation.setTickBudget(tickBudget);
+
+			double total = 0;
+			double best	 = 0;
+			double start = librapid::now();
+			for (int64_t generation = 0; generation < generations; ++generation) {
+				if (!runGeneration(simulation)) { return; }
+				total += simulation.distance();
+				best = std::max(best, simulation.distance());
+				simulation.nextGeneration();
+			}
+			double seconds = librapid::now() - start;
+
+			fmt::print("{},{},{},{},{},{}\n",
+					   interval,
+					   substeps,
+					   static_cast<double>(simulation.ticks()) / seconds,
+					   total / static_cast<double>(generations),
+					   best,
+					   seconds);
+		}
+	}
+}
+
+void printUsage() {
+	fmt::print("Usage: FlappyBirdAI_bench [options]\n"
+			   "  --populations <list>  Comma-separated population sizes (default: 1000,{},20000)\n"
+			   "  --threads <list>      Comma-separated thread counts (default: 1,{})\n"
+			   "  --min-time <s>        Minimum seconds to run each benchmark for (default: 0.2)\n"
+			   "  --filter <name>       Only run benchmarks whose names contain this\n"
+			   "  --format <f>          Output format: csv or json (default: csv)\n"
+			   "  --output <file>       Write the results to a file instead of the console\n"
+			   "  --parity <n>          Instead of benchmarking, train for n generations with\n"
+			   "                        each activation function and compare them with sigmoid\n"
+			   "  --decisions <n>       Instead of benchmarking, train for n generations with\n"
+			   "                        each decision interval and number of physics substeps\n",
+			   NUM_BIRDS,
+			   numThreads);
+}
+
+// Parse a comma-separated list of integers
+std::vector<int64_t> parseList(const std::string &value) {
+	std::vector<int64_t> list;
+	std::stringstream stream(value);
+	std::string item;
+	while (std::getline(stream, item, ',')) { list.push_back(std::stoll(item)); }
+	return list;
+}
+
+// Parse the command line, returning false if the program should exit immediately
+bool parseArguments(int argc, char **argv, BenchmarkOptions &options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--help" || arg == "-h") {
+			printUsage();
+			return false;
+		}
+
+		if (i + 1 >= argc) {
+			fmt::print(fmt::fg(fmt::color::red), "Missing value for argument '{}'\n", arg);
+			return false;
+		}
+
+		std::string value = argv[++i];
+		if (arg == "--populations") {
+			options.populations = parseList(value);
+		} else if (arg == "--threads") {
+			options.threads = parseList(value);
+		} else if (arg == "--min-time") {
+			options.minTime = std::stod(value);
+		} else if (arg == "--filter") {
+			options.filter = value;
+		} else if (arg == "--format" && (value == "csv" || value == "json")) {
+			options.format = value;
+		} else if (arg == "--output") {
+			options.output = value;
+		} else if (arg == "--parity") {
+			options.parity = std::stoll(value);
+		} else if (arg == "--decisions") {
+			options.decisions = std::stoll(value);
+		} else {
+			fmt::print(fmt::fg(fmt::color::red), "Unknown argument '{}'\n", arg);
+			printUsage();
+			return false;
+		}
+	}
+
+	// Don't run the same thread count twice (e.g. on a single-core machine)
+	std::sort(options.threads.begin(), options.threads.end());
+	options.threads.erase(std::unique(options.threads.begin(), options.threads.end()),
+						  options.threads.end());
+
+	return true;
+}
+
+int main(int argc, char **argv) {
+	BenchmarkOptions options;
+	if (!parseArguments(argc, argv, options)) { return 1; }
+
+	librapid::setNumThreads(1);
+
+	if (options.parity > 0) {
+		checkActivationParity(options.parity, NUM_BIRDS);
+		return 0;
+	}
+
+	if (options.decisions > 0) {
+		compareDecisionIntervals(options.decisions, NUM_BIRDS);
+		return 0;
+	}
+
+	BenchmarkRunner runner(options);
+	for (int64_t population : options.populations) {
+		benchmarkBrains(runner, population);
+		benchmarkSelection(runner, population);
+		benchmarkWorld(runner, population);
+		for (int64_t threads : options.threads) { benchmarkThreaded(runner, population, threads); }
+	}
+
+	std::string formatted = options.format == "json" ? formatJson(runner.results())
+													 : formatCsv(runner.results());
+
+	if (options.output.empty()) {
+		fmt::print("{}", formatted);
+		return 0;
+	}
+
+	std::FILE *file = std::fopen(options.output.c_str(), "w");
+	if (!file || std::fputs(formatted.c_str(), file) < 0) {
+		fmt::print(fmt::fg(fmt::color::red), "Unable to write results to '{}'\n", options.output);
+		if (file) { std::fclose(file); }
+		return 1;
+	}
+
+	std::fclose(file);
+	return 0;
+}
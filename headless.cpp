@@ -0,0 +1,558 @@
+#include "include/configuration.hpp"
+
+// Command line options for the headless trainer
+struct HeadlessOptions {
+	int64_t generations		= 0;				  // Stop after this many generations (0 = never)
+	double seconds			= 0;				  // Stop after this many seconds (0 = never)
+	int64_t population		= NUM_BIRDS;		  // Number of birds in the population
+	double reportInterval	= 1;				  // Seconds between throughput reports
+	int64_t threads			= numThreads;		  // Number of simulation threads
+	uint64_t seed			= RANDOM_SEED;		  // Seed for the simulation's random streams
+	std::string mutation	= "reset";			  // Mutation operator (reset or gaussian)
+	double sigma			= 0.1;				  // Standard deviation of Gaussian mutations
+	std::string selection	= "roulette";		  // Parent selection (roulette, tournament or rank)
+	int64_t tournament		= 3;				  // Birds in each tournament
+	std::string course		= "new";			  // Course for each generation (new or fixed)
+	int64_t islands			= 1;				  // Number of independent populations
+	int64_t interval		= MIGRATION_INTERVAL; // Generations between migrations
+	int64_t migrants		= NUM_MIGRANTS;		  // Genomes sent in each migration
+	int64_t episodes		= NUM_EPISODES;		  // Courses each genome is evaluated on
+	std::string aggregate	= "mean";			  // How episodes are combined (mean or min)
+	std::string replacement	= "generational";	  // When genomes are replaced (or steady)
+	int64_t tickBudget		= 0;				  // Ticks before a generation ends (0 = never)
+	std::string activation	= "sigmoid";		  // Activation of the brains' hidden layers
+	std::string checkpoint;						  // File to save checkpoints to (empty = none)
+	int64_t checkpointInterval = 10;			  // Generations between checkpoints
+	std::string resume;							  // Checkpoint to carry on from (empty = none)
+	std::string profile;						  // CSV file to stream phase timings to
+	std::string record;							  // File to append replays to (empty = none)
+	int64_t recordBirds = 1;					  // Birds to record each generation
+	std::string replay;							  // Replay file to re-simulate, then exit
+	std::string telemetry;						  // File to append statistics to (empty = none)
+	std::string exportTelemetry;				  // Telemetry file to print as CSV, then exit
+	int64_t checkAllocations = -1;				  // Warm-up generations before counting (-1 = off)
+	int64_t decisionInterval = 1;				  // Ticks between each bird's decisions
+	int64_t substeps		 = 1;				  // Physics steps in each tick
+};
+
+void printUsage() {
+	fmt::print("Usage: FlappyBirdAI_headless [options]\n"
+			   "  --generations <n>  Stop after n generations (default: run forever)\n"
+			   "  --seconds <s>      Stop after s seconds (default: run forever)\n"
+			   "  --population <n>   Number of birds (default: {})\n"
+			   "  --report <s>       Seconds between throughput reports (default: 1)\n"
+			   "  --threads <n>      Number of simulation threads (default: {})\n"
+			   "  --seed <n>         Random seed (default: {})\n"
+			   "  --mutation <op>    Mutation operator: reset or gaussian (default: reset)\n"
+			   "  --sigma <s>        Standard deviation of gaussian mutations (default: 0.1)\n"
+			   "  --selection <s>    Parent selection: roulette, tournament or rank (default: "
+			   "roulette)\n"
+			   "  --tournament <n>   Birds in each tournament (default: 3)\n"
+			   "  --course <c>       Course for each generation: new or fixed (default: new)\n"
+			   "  --islands <n>      Number of independent populations (default: 1). The\n"
+			   "                     population and threads are per island\n"
+			   "  --interval <n>     Generations between migrations (default: {})\n"
+			   "  --migrants <n>     Genomes sent in each migration (default: {})\n"
+			   "  --episodes <n>     Courses each genome is evaluated on at once (default: {})\n"
+			   "  --aggregate <a>    Fitness over the episodes: mean or min (default: mean)\n"
+			   "  --replacement <r>  generational, or steady to replace each genome as soon as\n"
+			   "                     its birds die (default: generational, and the only\n"
+			   "                     choice with more than one island)\n"
+			   "  --tick-budget <n>  End each generation (or course, in steady state) after n\n"
+			   "                     ticks, scoring survivors on their distance (default:\n"
+			   "                     never, or {} in steady state)\n"
+			   "  --activation <a>   Activation of the hidden layers: sigmoid, fast-sigmoid,\n"
+			   "                     tanh, relu or hard-sigmoid (default: sigmoid)\n"
+			   "  --decision-interval <n>  Evaluate each bird's brain every n ticks, repeating\n"
+			   "                     its decision in between (default: 1)\n"
+			   "  --substeps <n>     Physics steps in each tick (default: 1)\n"
+			   "  --checkpoint <f>   Save a checkpoint to f periodically and on exit\n"
+			   "  --checkpoint-every <n>  Generations between checkpoints (default: 10)\n"
+			   "  --resume <f>       Carry on from the checkpoint in f\n"
+			   "  --profile <f>      Write the time spent in each phase to a CSV file (needs a\n"
+			   "                     build with FLAPPY_BIRD_PROFILE)\n"
+			   "  --record <f>       Append a replay of each generation's elite to f\n"
+			   "  --record-birds <n> Record the first n birds instead (default: 1)\n"
+			   "  --replay <f>       Re-simulate every bird recorded in f and exit\n"
+			   "  --telemetry <f>    Append the statistics of every generation to f\n"
+			   "  --export-telemetry <f>  Print the statistics logged in f as CSV and exit\n"
+			   "  --check-allocations <g>  Count heap allocations in every tick after the first g\n"
+			   "                     generations, and fail if there were any (needs a build\n"
+			   "                     with FLAPPY_BIRD_COUNT_ALLOCATIONS)\n"
+			   "With more than one island, each island's checkpoint has its index appended.\n",
+			   NUM_BIRDS,
+			   numThreads,
+			   RANDOM_SEED,
+			   MIGRATION_INTERVAL,
+			   NUM_MIGRANTS,
+			   NUM_EPISODES,
+			   STEADY_STATE_COURSE_TICKS);
+}
+
+// Parse the command line, returning false if the program should exit immediately
+bool parseArguments(int argc, char **argv, HeadlessOptions &options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		if (arg == "--help" || arg == "-h") {
+			printUsage();
+			return false;
+		}
+
+		if (i + 1 >= argc) {
+			fmt::print(fmt::fg(fmt::color::red), "Missing value for argument '{}'\n", arg);
+			return false;
+		}
+
+		std::string value = argv[++i];
+		if (arg == "--generations") {
+			options.generations = std::stoll(value);
+		} else if (arg == "--seconds") {
+			options.seconds = std::stod(value);
+		} else if (arg == "--population") {
+			options.population = std::stoll(value);
+		} else if (arg == "--report") {
+			options.reportInterval = std::stod(value);
+		} else if (arg == "--threads") {
+			options.threads = std::stoll(value);
+		} else if (arg == "--seed") {
+			options.seed = std::stoull(value);
+		} else if (arg == "--mutation" && (value == "reset" || value == "gaussian")) {
+			options.mutation = value;
+		} else if (arg == "--sigma") {
+			options.sigma = std::stod(value);
+		} else if (arg == "--selection" &&
+				   (value == "roulette" || value == "tournament" || value == "rank")) {
+			options.selection = value;
+		} else if (arg == "--tournament") {
+			options.tournament = std::stoll(value);
+		} else if (arg == "--course" && (value == "new" || value == "fixed")) {
+			options.course = value;
+		} else if (arg == "--islands") {
+			options.islands = std::stoll(value);
+		} else if (arg == "--interval") {
+			options.interval = std::stoll(value);
+		} else if (arg == "--migrants") {
+			options.migrants = std::stoll(value);
+		} else if (arg == "--episodes") {
+			options.episodes = std::stoll(value);
+		} else if (arg == "--aggregate" && (value == "mean" || value == "min")) {
+			options.aggregate = value;
+		} else if (arg == "--replacement" && (value == "generational" || value == "steady")) {
+			options.replacement = value;
+		} else if (arg == "--tick-budget") {
+			options.tickBudget = std::stoll(value);
+		} else if (arg == "--activation" &&
+				   std::find(activationNames.begin(), activationNames.end(), value) !=
+					 activationNames.end()) {
+			options.activation = value;
+		} else if (arg == "--decision-interval") {
+			options.decisionInterval = std::stoll(value);
+		} else if (arg == "--substeps") {
+			options.substeps = std::stoll(value);
+		} else if (arg == "--checkpoint") {
+			options.checkpoint = value;
+		} else if (arg == "--checkpoint-every") {
+			options.checkpointInterval = std::stoll(value);
+		} else if (arg == "--resume") {
+			options.resume = value;
+		} else if (arg == "--profile") {
+			options.profile = value;
+		} else if (arg == "--record") {
+			options.record = value;
+		} else if (arg == "--record-birds") {
+			options.recordBirds = std::stoll(value);
+		} else if (arg == "--replay") {
+			options.replay = value;
+		} else if (arg == "--telemetry") {
+			options.telemetry = value;
+		} else if (arg == "--export-telemetry") {
+			options.exportTelemetry = value;
+		} else if (arg == "--check-allocations") {
+			options.checkAllocations = std::stoll(value);
+		} else {
+			fmt::print(fmt::fg(fmt::color::red), "Unknown argument '{}'\n", arg);
+			printUsage();
+			return false;
+		}
+	}
+
+	// Islands only migrate between generations, which never end in steady state
+	if (options.islands > 1 && options.replacement == "steady") {
+		fmt::print(fmt::fg(fmt::color::red),
+				   "Steady-state replacement can't be used with more than one island\n");
+		return false;
+	}
+
+	return true;
+}
+
+// Apply the mutation, selection, course, checkpoint, replay and telemetry options to a simulation,
+// resuming from a checkpoint if requested. `suffix` is appended to checkpoint, replay and telemetry
+// file names. Returns false if the checkpoint couldn't be loaded or a log couldn't be opened
+bool configureSimulation(Simulation &simulation, const HeadlessOptions &options,
+						 const std::string &suffix = "") {
+	if (options.mutation == "gaussian") {
+		simulation.mutation().setOperator(MutationOperator::Gaussian).setGaussian(options.sigma, 1);
+	}
+
+	if (options.selection == "tournament") {
+		simulation.selector() = ParentSelector(SelectionStrategy::Tournament, options.tournament);
+	} else if (options.selection == "rank") {
+		simulation.selector() = ParentSelector(SelectionStrategy::Rank);
+	}
+
+	simulation.setFixedCourse(options.course == "fixed");
+	simulation.setFitnessAggregation(options.aggregate == "min" ? FitnessAggregation::Min
+																: FitnessAggregation::Mean);
+	simulation.setSteadyState(options.replacement == "steady");
+	simulation.setTickBudget(options.tickBudget);
+	Activation activation = Activation::Sigmoid;
+	parseActivation(options.activation, activation);
+	simulation.setActivation(activation);
+	simulation.setDecisionInterval(options.decisionInterval);
+	simulation.setSubsteps(options.substeps);
+
+	if (!options.checkpoint.empty()) {
+		simulation.setCheckpoints(options.checkpoint + suffix, options.checkpointInterval);
+	}
+
+	if (!options.record.empty()) {
+		std::vector<int64_t> birds(std::max<int64_t>(options.recordBirds, 1));
+		for (size_t i = 0; i < birds.size(); ++i) { birds[i] = i; }
+		simulation.setReplayBirds(birds);
+		if (!simulation.setReplayLog(options.record + suffix)) { return false; }
+	}
+
+	if (!options.telemetry.empty() && !simulation.setTelemetryLog(options.telemetry + suffix)) {
+		return false;
+	}
+
+	if (!options.resume.empty()) {
+		if (!simulation.loadCheckpoint(options.resume + suffix)) { return false; }
+		fmt::print("Resuming from generation {}.\n", simulation.generation() + 1);
+	}
+
+	return true;
+}
+
+// Streams the time spent in each phase to a CSV file at every report, if requested
+class HeadlessProfiler {
+public:
+	explicit HeadlessProfiler(const std::string &path) {
+		if (path.empty()) { return; }
+
+		if (profilingEnabled) {
+			m_log = std::make_unique<ProfileLog>(path);
+		} else {
+			fmt::print(fmt::fg(fmt::color::yellow),
+					   "Built without FLAPPY_BIRD_PROFILE, so no profile will be written.\n");
+		}
+	}
+
+	// Write the time spent in each phase since the last report
+	void report(double time) {
+		PhaseTimes times = Profiler::instance().snapshot();
+		if (m_log) { m_log->write(time, times - m_last); }
+		m_last = times;
+	}
+
+	// Print the total time spent in each phase
+	void summarise() const {
+		if (!profilingEnabled) { return; }
+
+		PhaseTimes times = Profiler::instance().snapshot() - m_start;
+		double total	 = std::max(times.totalMilliseconds(), 1e-9);
+		for (int64_t i = 0; i < numPhases; ++i) {
+			fmt::print("{:>12}: {:>12.1f} ms ({:>5.1f}%)\n",
+					   phaseNames[i],
+					   times.milliseconds(i),
+					   times.milliseconds(i) / total * 100);
+		}
+	}
+
+private:
+	std::unique_ptr<ProfileLog> m_log;
+	PhaseTimes m_start = Profiler::instance().snapshot();
+	PhaseTimes m_last  = m_start;
+};
+
+// Re-simulate every bird in a replay file, checking that each one flies exactly as far as it did
+// when it was recorded
+int runReplays(const std::string &path) {
+	double startTime = librapid::now();
+	auto records	 = readReplays(path);
+	if (records.empty()) {
+		fmt::print(fmt::fg(fmt::color::red), "No replays found in '{}'\n", path);
+		return 1;
+	}
+
+	int64_t mismatches = 0;
+	int64_t ticks	   = 0;
+	for (const auto &record : records) {
+		ReplayPlayer player(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT}, record);
+		double distance = player.run();
+		bool matches	= std::abs(distance - record.header.distance) < 1e-6;
+		mismatches += !matches;
+		ticks += player.tick();
+
+		fmt::print(matches ? fmt::fg(fmt::color::white) : fmt::fg(fmt::color::red),
+				   "Generation {:>6} | Bird {:>7} | Ticks: {:>9} | Recorded: {:>10.1f} | "
+				   "Replayed: {:>10.1f}\n",
+				   record.header.generation,
+				   record.header.bird,
+				   record.header.ticks,
+				   record.header.distance,
+				   distance);
+	}
+
+	double elapsed = librapid::now() - startTime;
+	fmt::print(mismatches == 0 ? fmt::fg(fmt::color::lime_green) : fmt::fg(fmt::color::red),
+			   "Replayed {} record(s) ({} ticks) in {}. {} did not match.\n",
+			   records.size(),
+			   ticks,
+			   librapid::formatTime(elapsed),
+			   mismatches);
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+// Print every generation in a telemetry file as CSV, with a header row naming the columns
+int exportTelemetry(const std::string &path) {
+	auto rows = readTelemetry(path);
+	if (rows.empty()) {
+		fmt::print(fmt::fg(fmt::color::red), "No telemetry found in '{}'\n", path);
+		return 1;
+	}
+
+	std::string line;
+	for (int64_t column = 0; column < numTelemetryColumns; ++column) {
+		line += fmt::format("{}{}", column > 0 ? "," : "", telemetryColumnNames[column]);
+	}
+	fmt::print("{}\n", line);
+
+	for (const auto &row : rows) {
+		line.clear();
+		for (int64_t column = 0; column < numTelemetryColumns; ++column) {
+			line += fmt::format("{}{}", column > 0 ? "," : "", row.*telemetryColumns[column]);
+		}
+		fmt::print("{}\n", line);
+	}
+
+	return 0;
+}
+
+// Run several islands on background threads, reporting on all of them from this thread
+int runIslands(const HeadlessOptions &options) {
+	IslandModel islands(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT},
+						options.islands,
+						options.population,
+						options.seed,
+						options.threads,
+						options.interval,
+						options.migrants,
+						options.episodes);
+	for (int64_t i = 0; i < islands.size(); ++i) {
+		if (!configureSimulation(islands.island(i), options, fmt::format(".{}", i))) { return 1; }
+	}
+
+	fmt::print("Running {} islands with {} thread(s) each and seed {}.\n",
+			   islands.size(),
+			   islands.island(0).threads(),
+			   options.seed);
+
+	// Sum the progress of every island
+	auto total = [&]() {
+		IslandSummary sum {0, 0, 0, 0, 0, 0};
+		sum.generation = INT64_MAX;
+		for (int64_t i = 0; i < islands.size(); ++i) {
+			IslandSummary summary = islands.summary(i);
+			sum.generation		  = std::min(sum.generation, summary.generation);
+			sum.ticks += summary.ticks;
+			sum.bestDistance = std::max(sum.bestDistance, summary.bestDistance);
+			sum.migrantsIn += summary.migrantsIn;
+		}
+		return sum;
+	};
+
+	HeadlessProfiler profiler(options.profile);
+	double startTime	  = librapid::now();
+	double lastReportTime = startTime;
+	IslandSummary last	  = total();
+	if (!islands.start()) { return 1; }
+
+	while (true) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		// Every island has to finish the requested number of generations
+		IslandSummary current = total();
+		if (options.generations > 0 && current.generation >= options.generations) { break; }
+
+		double now = librapid::now();
+		if (now - lastReportTime >= options.reportInterval) {
+			double elapsed = now - lastReportTime;
+			fmt::print(fmt::fg(fmt::color::purple) | fmt::emphasis::bold,
+					   "Ticks/s: {:>12.1f} | Generation: {:>6} | Best: {:>10.1f} | Migrants: {}\n",
+					   static_cast<double>(current.ticks - last.ticks) / elapsed,
+					   current.generation,
+					   current.bestDistance,
+					   current.migrantsIn);
+
+			profiler.report(now - startTime);
+			lastReportTime = now;
+			last		   = current;
+		}
+
+		if (options.seconds > 0 && now - startTime >= options.seconds) { break; }
+	}
+
+	islands.stop();
+
+	if (!options.checkpoint.empty()) {
+		for (int64_t i = 0; i < islands.size(); ++i) {
+			islands.island(i).saveCheckpoint(fmt::format("{}.{}", options.checkpoint, i));
+			islands.island(i).waitForCheckpoint();
+		}
+	}
+
+	double elapsed = librapid::now() - startTime;
+	profiler.summarise();
+	for (int64_t i = 0; i < islands.size(); ++i) {
+		IslandSummary summary = islands.summary(i);
+		fmt::print("Island {}: {} generations, best distance {:.1f}, migrants in/out {} / {}.\n",
+				   i,
+				   summary.generation,
+				   summary.bestDistance,
+				   summary.migrantsIn,
+				   summary.migrantsOut);
+	}
+
+	IslandSummary sum = total();
+	fmt::print(fmt::fg(fmt::color::lime_green) | fmt::emphasis::bold,
+			   "Simulated {} ticks in {} ({:.1f} ticks/s). Best distance: {:.1f}.\n",
+			   sum.ticks,
+			   librapid::formatTime(elapsed),
+			   static_cast<double>(sum.ticks) / elapsed,
+			   sum.bestDistance);
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	HeadlessOptions options;
+	if (!parseArguments(argc, argv, options)) { return 1; }
+
+	// Nothing else is printed, so the CSV can be redirected straight to a file
+	if (!options.exportTelemetry.empty()) { return exportTelemetry(options.exportTelemetry); }
+
+	fmt::print(fmt::fg(fmt::color::orange_red) | fmt::emphasis::bold,
+			   "Welcome to Flappy Bird AI (headless)!\n");
+
+	librapid::setNumThreads(1);
+
+	if (!options.replay.empty()) { return runReplays(options.replay); }
+	if (options.islands > 1) { return runIslands(options); }
+
+	// No window is created, so the simulation runs as fast as the CPU allows
+	Simulation simulation(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT},
+						  options.population,
+						  options.seed,
+						  options.threads,
+						  options.episodes);
+	fmt::print("Running with {} thread(s), {} episode(s) and seed {}.\n",
+			   simulation.threads(),
+			   simulation.episodes(),
+			   options.seed);
+	if (!configureSimulation(simulation, options)) { return 1; }
+
+	HeadlessProfiler profiler(options.profile);
+	double startTime		= librapid::now();
+	double lastReportTime	= startTime;
+	int64_t lastReportTicks = simulation.ticks();
+	int64_t lastReportGens	= simulation.generation();
+	int64_t startTicks		= simulation.ticks();
+	int64_t startGens		= simulation.generation();
+
+	// Once every buffer has grown to its full size, a tick shouldn't allocate at all. Breeding a
+	// new generation is allowed to, so only the ticks themselves are counted
+	const bool checkAllocations = options.checkAllocations >= 0;
+	uint64_t tickAllocations	= 0;
+	int64_t checkedTicks		= 0;
+	if (checkAllocations && !allocationCountingEnabled) {
+		fmt::print(fmt::fg(fmt::color::red),
+				   "Built without FLAPPY_BIRD_COUNT_ALLOCATIONS, so allocations can't be "
+				   "counted.\n");
+		return 1;
+	}
+
+	while (true) {
+		uint64_t allocationsBefore = allocationCount();
+		int64_t alive			   = simulation.tick();
+		if (checkAllocations &&
+			simulation.generation() - startGens >= options.checkAllocations) {
+			tickAllocations += allocationCount() - allocationsBefore;
+			++checkedTicks;
+		}
+
+		if (alive == 0) {
+			fmt::print(fmt::fg(fmt::color::orange_red) | fmt::emphasis::bold,
+					   "Generation {} survived a distance of {:.1f}.\n",
+					   simulation.generation() + 1,
+					   simulation.distance());
+
+			simulation.nextGeneration();
+		}
+
+		// In steady-state mode, the generation counter goes up without every bird dying
+		if (options.generations > 0 && simulation.generation() >= options.generations) { break; }
+
+		// Checking the clock is relatively expensive, so only do it occasionally
+		if (simulation.ticks() % 256 != 0) { continue; }
+
+		double now = librapid::now();
+		if (now - lastReportTime >= options.reportInterval) {
+			double elapsed = now - lastReportTime;
+			fmt::print(fmt::fg(fmt::color::purple) | fmt::emphasis::bold,
+					   "Ticks/s: {:>12.1f} | Generations/s: {:>8.3f} | Alive: {:>7} / {:>7}\n",
+					   static_cast<double>(simulation.ticks() - lastReportTicks) / elapsed,
+					   static_cast<double>(simulation.generation() - lastReportGens) / elapsed,
+					   alive,
+					   simulation.birds().size());
+
+			profiler.report(now - startTime);
+			lastReportTime	= now;
+			lastReportTicks = simulation.ticks();
+			lastReportGens	= simulation.generation();
+		}
+
+		if (options.seconds > 0 && now - startTime >= options.seconds) { break; }
+	}
+
+	if (!options.checkpoint.empty()) {
+		simulation.saveCheckpoint(options.checkpoint);
+		simulation.waitForCheckpoint();
+	}
+
+	double elapsed = librapid::now() - startTime;
+	profiler.summarise();
+	fmt::print(fmt::fg(fmt::color::lime_green) | fmt::emphasis::bold,
+			   "Simulated {} ticks and {} generations in {} ({:.1f} ticks/s, {:.3f} "
+			   "generations/s).\n",
+			   simulation.ticks() - startTicks,
+			   simulation.generation() - startGens,
+			   librapid::formatTime(elapsed),
+			   static_cast<double>(simulation.ticks() - startTicks) / elapsed,
+			   static_cast<double>(simulation.generation() - startGens) / elapsed);
+
+	if (checkAllocations) {
+		auto colour =
+		  tickAllocations == 0 ? fmt::fg(fmt::color::lime_green) : fmt::fg(fmt::color::red);
+		fmt::print(colour,
+				   "{} heap allocation(s) in {} checked tick(s).\n",
+				   tickAllocations,
+				   checkedTicks);
+		if (tickAllocations > 0) { return 1; }
+	}
+
+	return 0;
+}
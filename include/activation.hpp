@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// The activation functions available to the brains. Each one is a struct with a static apply()
+// that the brains take as a template parameter, so the activation is inlined into the layer loop.
+// Apart from the exact sigmoid and tanh, every activation is a handful of arithmetic operations
+// with no branches or calls, so the compiler vectorises the loop over a layer's outputs.
+//
+// Every activation is monotonic and maps a pre-activation of 0 to its threshold, so whether an
+// output is above its threshold is the same as whether its pre-activation is above 0. A bird's
+// jump decision therefore doesn't need the output layer's activation at all (see PopulationBrain).
+enum class Activation {
+	Sigmoid,	 // 1 / (1 + e^-x), computed exactly
+	FastSigmoid, // 0.5 + 0.5x / (1 + |x|), a rational approximation of the sigmoid
+	Tanh,		 // tanh(x), computed exactly
+	ReLU,		 // max(x, 0)
+	HardSigmoid	 // clamp(0.2x + 0.5, 0, 1), a piecewise-linear approximation of the sigmoid
+};
+
+static constexpr int64_t numActivations = 5;
+
+static constexpr std::array<const char *, numActivations> activationNames = {
+  "sigmoid", "fast-sigmoid", "tanh", "relu", "hard-sigmoid"};
+
+struct SigmoidActivation {
+	static constexpr Activation kind = Activation::Sigmoid;
+
+	template<typename Scalar>
+	static Scalar apply(Scalar x) { return Scalar(1) / (Scalar(1) + std::exp(-x)); }
+};
+
+struct FastSigmoidActivation {
+	static constexpr Activation kind = Activation::FastSigmoid;
+
+	template<typename Scalar>
+	static Scalar apply(Scalar x) {
+		return Scalar(0.5) + Scalar(0.5) * x / (Scalar(1) + std::abs(x));
+	}
+};
+
+struct TanhActivation {
+	static constexpr Activation kind = Activation::Tanh;
+
+	template<typename Scalar>
+	static Scalar apply(Scalar x) { return std::tanh(x); }
+};
+
+struct ReluActivation {
+	static constexpr Activation kind = Activation::ReLU;
+
+	template<typename Scalar>
+	static Scalar apply(Scalar x) { return std::max(x, Scalar(0)); }
+};
+
+struct HardSigmoidActivation {
+	static constexpr Activation kind = Activation::HardSigmoid;
+
+	template<typename Scalar>
+	static Scalar apply(Scalar x) {
+		return std::clamp(Scalar(0.2) * x + Scalar(0.5), Scalar(0), Scalar(1));
+	}
+};
+
+// Call `func` with an instance of the struct for a given activation, so a kernel chosen at run
+// time can still have its activation inlined
+template<typename Func>
+decltype(auto) dispatchActivation(Activation activation, Func &&func) {
+	switch (activation) {
+		case Activation::FastSigmoid: return func(FastSigmoidActivation {});
+		case Activation::Tanh: return func(TanhActivation {});
+		case Activation::ReLU: return func(ReluActivation {});
+		case Activation::HardSigmoid: return func(HardSigmoidActivation {});
+		default: return func(SigmoidActivation {});
+	}
+}
+
+// Find the activation with a given name. Returns false if there isn't one
+bool parseActivation(const std::string &name, Activation &activation) {
+	for (int64_t i = 0; i < numActivations; ++i) {
+		if (name == activationNames[i]) {
+			activation = static_cast<Activation>(i);
+			return true;
+		}
+	}
+	return false;
+}
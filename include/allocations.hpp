@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation made by the program, so that code which should never allocate
+// (such as a steady-state tick) can be checked. Configure with -DFLAPPY_BIRD_COUNT_ALLOCATIONS=ON
+// to replace the global operator new with a counting version. This header must only be included
+// in a single translation unit, which is always the case since each program is built from one.
+#if defined(FLAPPY_BIRD_COUNT_ALLOCATIONS)
+static constexpr bool allocationCountingEnabled = true;
+
+std::atomic<uint64_t> allocationCounter {0};
+
+// Allocate `size` bytes with the given alignment, counting the allocation
+void *countedAllocate(size_t size, size_t alignment) {
+	allocationCounter.fetch_add(1, std::memory_order_relaxed);
+	if (size == 0) { size = 1; }
+
+	void *pointer = nullptr;
+	if (alignment <= alignof(std::max_align_t)) {
+		pointer = std::malloc(size);
+	} else {
+		// aligned_alloc needs the size to be a multiple of the alignment
+		pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+	}
+	return pointer;
+}
+
+void *operator new(size_t size) {
+	void *pointer = countedAllocate(size, alignof(std::max_align_t));
+	if (!pointer) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void *operator new[](size_t size) {
+	void *pointer = countedAllocate(size, alignof(std::max_align_t));
+	if (!pointer) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+	void *pointer = countedAllocate(size, static_cast<size_t>(alignment));
+	if (!pointer) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+	void *pointer = countedAllocate(size, static_cast<size_t>(alignment));
+	if (!pointer) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+
+// The number of heap allocations made so far, on every thread
+uint64_t allocationCount() { return allocationCounter.load(std::memory_order_relaxed); }
+#else
+static constexpr bool allocationCountingEnabled = false;
+
+uint64_t allocationCount() { return 0; }
+#endif
@@ -1,185 +1,376 @@
 #pragma once
 
-// A class representing a "bird" in the game, capable of moving and jumping with a brain that
-// determines its actions
+// The whole population of "birds" in the game, each capable of moving and jumping with a brain that
+// determines its actions.
+//
+// The state of the birds is stored as a structure of arrays: every bird's y position, velocity,
+// acceleration, alive flag and fitness live in separate contiguous arrays, so the physics step only
+// streams through the data it needs (and can be vectorised). The brains live separately in a
+// GenomeArena. Every bird has the same size and horizontal position.
+//
+// The population also keeps a compacted list of the indices of its living birds, in increasing
+// order. Every per-tick stage walks this list rather than the whole population, so once most of a
+// generation has died, a tick only costs as much as the survivors.
 template<typename Scalar, typename Backend>
-class BirdImpl {
+class BirdPopulationImpl {
 public:
-	using BirdBrain = Brain<Scalar, Backend>;
-	using Array		= librapid::Array<Scalar, Backend>;
+	using Array = librapid::Array<Scalar, Backend>;
 
-	BirdImpl()						= default;
-	BirdImpl(const BirdImpl &other) = default;
-	BirdImpl(BirdImpl &&other)		= default;
+	BirdPopulationImpl()								= default;
+	BirdPopulationImpl(const BirdPopulationImpl &other) = default;
+	BirdPopulationImpl(BirdPopulationImpl &&other)		= default;
 
-	BirdImpl(const librapid::Vec2d &size, const librapid::Vec2d &position, double velocity,
-			 double acceleration, double timeScale = 1.0) :
+	BirdPopulationImpl(int64_t size, const librapid::Vec2d &birdSize, double x,
+					   double timeScale = 1.0) :
 			m_size(size),
-			m_position(position), m_velocity(velocity), m_acceleration(acceleration),
-			m_timeScale(timeScale) {}
-
-	BirdImpl &operator=(const BirdImpl &other) = default;
-	BirdImpl &operator=(BirdImpl &&other)	   = default;
+			m_birdSize(birdSize), m_x(x), m_timeScale(timeScale), m_y(size), m_velocity(size),
+			m_acceleration(size), m_alive(size), m_fitness(size), m_active(size), m_died(size) {}
+
+	BirdPopulationImpl &operator=(const BirdPopulationImpl &other) = default;
+	BirdPopulationImpl &operator=(BirdPopulationImpl &&other)	   = default;
+
+	// Bring every bird back to life at a given height, with no velocity or fitness
+	void reset(double y) {
+		std::fill(m_y.begin(), m_y.end(), y);
+		std::fill(m_velocity.begin(), m_velocity.end(), 0.0);
+		std::fill(m_acceleration.begin(), m_acceleration.end(), 0.0);
+		std::fill(m_alive.begin(), m_alive.end(), 1);
+		std::fill(m_fitness.begin(), m_fitness.end(), 0.0);
+
+		for (int64_t i = 0; i < m_size; ++i) { m_active[i] = i; }
+		m_numActive = m_size;
+		m_numDied	= 0;
+	}
 
-	[[nodiscard]] surge::Rectangle rectangle() const {
-		return surge::Rectangle(m_position, m_size);
+	[[nodiscard]] surge::Rectangle rectangle(int64_t index) const {
+		return surge::Rectangle(librapid::Vec2d(m_x, m_y[index]), m_birdSize);
 	}
 
-	[[nodiscard]] const librapid::Vec2d &size() const { return m_size; }
-	[[nodiscard]] const librapid::Vec2d &position() const { return m_position; }
-	[[nodiscard]] const double &velocity() const { return m_velocity; }
-	[[nodiscard]] const double &acceleration() const { return m_acceleration; }
-	[[nodiscard]] const BirdBrain &brain() const { return m_brain; }
+	[[nodiscard]] int64_t size() const { return m_size; }
+	[[nodiscard]] const librapid::Vec2d &birdSize() const { return m_birdSize; }
+	[[nodiscard]] double x() const { return m_x; }
 	[[nodiscard]] double timeScale() const { return m_timeScale; }
-	[[nodiscard]] bool alive() const { return m_alive; }
-	[[nodiscard]] double fitness() const { return m_fitness; }
-
-	librapid::Vec2d &size() { return m_size; }
-	librapid::Vec2d &position() { return m_position; }
-	double &velocity() { return m_velocity; }
-	double &acceleration() { return m_acceleration; }
-	BirdBrain &brain() { return m_brain; }
-	double &timeScale() { return m_timeScale; }
-	bool &alive() { return m_alive; }
-	double &fitness() { return m_fitness; }
-
-	void kill(double fitness) {
-		if (!m_alive) return; // Dead birds can't die again :P
-		m_alive	  = false;
-		m_fitness = fitness * fitness; // Square the fitness to emphasize the importance of
-									   // surviving longer
+	[[nodiscard]] double y(int64_t index) const { return m_y[index]; }
+	[[nodiscard]] double velocity(int64_t index) const { return m_velocity[index]; }
+	[[nodiscard]] double acceleration(int64_t index) const { return m_acceleration[index]; }
+	[[nodiscard]] bool alive(int64_t index) const { return m_alive[index]; }
+	[[nodiscard]] double fitness(int64_t index) const { return m_fitness[index]; }
+	[[nodiscard]] const std::vector<double> &fitnesses() const { return m_fitness; }
+
+	// The indices of the birds alive after the last call to mergeActive() (or reset())
+	[[nodiscard]] const int64_t *active() const { return m_active.data(); }
+	[[nodiscard]] int64_t numActive() const { return m_numActive; }
+	int64_t *active() { return m_active.data(); }
+
+	// The indices of the birds that died in the steps joined by the last call to mergeDied(), in
+	// increasing order. Birds killed by killActive() aren't included
+	[[nodiscard]] const int64_t *died() const { return m_died.data(); }
+	[[nodiscard]] int64_t numDied() const { return m_numDied; }
+	int64_t *died() { return m_died.data(); }
+
+	double &y(int64_t index) { return m_y[index]; }
+	double &velocity(int64_t index) { return m_velocity[index]; }
+	double &acceleration(int64_t index) { return m_acceleration[index]; }
+	double &fitness(int64_t index) { return m_fitness[index]; }
+
+	void kill(int64_t index, double fitness) {
+		if (!m_alive[index]) return; // Dead birds can't die again :P
+		m_alive[index]	 = 0;
+		m_fitness[index] = fitness * fitness; // Square the fitness to emphasize the importance of
+											  // surviving longer
 	}
 
-	void update() {
-		if (!m_alive) return;
+	void jump(int64_t index) {
+		// To jump, we can simply set the birds velocity. A negative value points up the screen
+		m_velocity[index] = -BIRD_JUMP_VELOCITY;
+	}
+
+	// Apply gravity to the birds at positions [begin, end) of the active list, move them, and kill
+	// any whose top edge ends up above `ceiling` or below `floor`. These bounds come from the world
+	// query, so they cover the walls as well as the top and bottom of the world. The survivors are
+	// then compacted, in order, to the start of the range: every bird is written to the next free
+	// position, which only advances if the bird is still alive, so the loop has no branches. Any
+	// bird already dead (see kill()) is dropped too. Returns the number of survivors.
+	//
+	// The birds that die are compacted the same way to the start of the same range of died(), so
+	// the range's survivors and its dead together account for every bird that was in it.
+	//
+	// The tick can be split into `substeps` smaller steps, each checked for collisions, so a fast
+	// bird can't pass through a thin gap edge between ticks. The walls don't move between substeps.
+	int64_t step(int64_t begin, int64_t end, double gravity, double ceiling, double floor,
+				 double distance, int64_t substeps = 1) {
+		const double fitness   = distance * distance;
+		const double timeScale = m_timeScale / static_cast<double>(substeps);
+
+		double *y			 = m_y.data();
+		double *velocity	 = m_velocity.data();
+		double *acceleration = m_acceleration.data();
+		uint8_t *alive		 = m_alive.data();
+		double *fitnesses	 = m_fitness.data();
+		int64_t *active		 = m_active.data() + begin;
+		int64_t *died		 = m_died.data() + begin;
+
+		int64_t numAlive = 0;
+		for (int64_t k = 0; k < end - begin; ++k) {
+			const int64_t i = active[k];
+
+			// Simple physics implementation, checking for collisions with the ceiling, floor and
+			// walls after every substep
+			uint8_t hit = 0;
+			for (int64_t s = 0; s < substeps; ++s) {
+				acceleration[i] = gravity;
+				velocity[i] += acceleration[i] * timeScale;
+				y[i] += velocity[i] * timeScale;
+				acceleration[i] = 0;
+				hit |= (y[i] < ceiling) | (y[i] > floor);
+			}
+
+			const uint8_t dies = hit & alive[i];
+			fitnesses[i]	   = dies ? fitness : fitnesses[i];
+			alive[i] &= static_cast<uint8_t>(!hit);
 
-		// Simple physics implementation
-		m_velocity += m_acceleration * m_timeScale;
-		m_position.y() += m_velocity * m_timeScale;
-		m_acceleration *= 0.0;
+			active[numAlive]   = i;
+			died[k - numAlive] = i;
+			numAlive += alive[i];
+		}
+
+		return numAlive;
 	}
 
-	void draw(surge::Color color = surge::Color::cyan) const {
-		if (!m_alive) return;
+	// Kill every living bird, as if it had died at `distance`, and empty the active list
+	void killActive(double distance) {
+		for (int64_t k = 0; k < m_numActive; ++k) {
+			m_alive[m_active[k]]   = 0;
+			m_fitness[m_active[k]] = distance * distance;
+		}
+		m_numActive = 0;
+	}
 
-		// Draw a solid rectangle with an outline
-		rectangle().draw(color);
-		rectangle().setThickness(5).drawLines(surge::Color::blue);
+	// Bring some dead birds back to life at a given height, with no velocity or fitness, and add
+	// them to the active list. `indices` must be in increasing order. The two sorted lists are
+	// merged from the back, so the active list stays in order without any extra memory
+	void revive(const std::vector<int64_t> &indices, double y) {
+		for (int64_t i : indices) {
+			m_y[i]			  = y;
+			m_velocity[i]	  = 0;
+			m_acceleration[i] = 0;
+			m_alive[i]		  = 1;
+			m_fitness[i]	  = 0;
+		}
+
+		int64_t from  = m_numActive - 1;
+		int64_t next  = static_cast<int64_t>(indices.size()) - 1;
+		int64_t write = m_numActive + next;
+		while (next >= 0) {
+			if (from >= 0 && m_active[from] > indices[next]) {
+				m_active[write--] = m_active[from--];
+			} else {
+				m_active[write--] = indices[next--];
+			}
+		}
+		m_numActive += indices.size();
 	}
 
-	void jump() {
-		// To jump, we can simply set the birds velocity. A negative value points up the screen
-		m_velocity = -BIRD_JUMP_VELOCITY;
+	// Join up the active list after it has been stepped in chunks. Chunk i started at position
+	// begins[i] and its counts[i] survivors were compacted to the start of it. The chunks must be
+	// in increasing order of position
+	void mergeActive(const std::vector<int64_t> &begins, const std::vector<int64_t> &counts) {
+		int64_t total = 0;
+		for (size_t i = 0; i < begins.size(); ++i) {
+			std::copy_n(m_active.data() + begins[i], counts[i], m_active.data() + total);
+			total += counts[i];
+		}
+		m_numActive = total;
+	}
+
+	// Join up the lists of birds that died after the active list has been stepped in chunks, in the
+	// same way as mergeActive(). Chunk i's counts[i] dead were compacted to the start of it
+	void mergeDied(const std::vector<int64_t> &begins, const std::vector<int64_t> &counts) {
+		int64_t total = 0;
+		for (size_t i = 0; i < begins.size(); ++i) {
+			std::copy_n(m_died.data() + begins[i], counts[i], m_died.data() + total);
+			total += counts[i];
+		}
+		m_numDied = total;
+	}
+
+	void draw(int64_t index, surge::Color color = surge::Color::cyan) const {
+		if (!m_alive[index]) return;
+
+		// Draw a solid rectangle with an outline
+		rectangle(index).draw(color);
+		rectangle(index).setThickness(5).drawLines(surge::Color::blue);
 	}
 
 private:
-	librapid::Vec2d m_size;
-	librapid::Vec2d m_position;
-	double m_velocity;
-	double m_acceleration;
-	double m_timeScale;
-
-	bool m_alive	 = true;
-	double m_fitness = 0;
-	BirdBrain m_brain;
+	int64_t m_size = 0;			// Number of birds in the population
+	librapid::Vec2d m_birdSize; // Size of every bird
+	double m_x		   = 0;		// Horizontal position of every bird
+	double m_timeScale = 1;
+
+	std::vector<double> m_y;
+	std::vector<double> m_velocity;
+	std::vector<double> m_acceleration;
+	std::vector<uint8_t> m_alive;
+	std::vector<double> m_fitness;
+
+	std::vector<int64_t> m_active; // Indices of the living birds, compacted to the front
+	int64_t m_numActive = 0;	   // Number of living birds in m_active
+	std::vector<int64_t> m_died;   // Indices of the birds that died, compacted to the front
+	int64_t m_numDied = 0;		   // Number of dead birds in m_died
 };
 
-using Bird = BirdImpl<Scalar, Backend>;
+using BirdPopulation = BirdPopulationImpl<Scalar, Backend>;
 
 // Create a new bird brain, which is a neural network with 5 inputs and 1 output. The hidden layers
-// can be customised
-Bird::BirdBrain createBirdBrain() {
-	Bird::BirdBrain brain;
-	brain << 5 << 8 << 5 << 1;
-	brain.construct();
+// can be customised through BirdBrain in configuration.hpp
+BirdBrain createBirdBrain(Random &random) {
+	BirdBrain brain;
+	brain.construct(random);
 	return brain;
 }
 
-// Given a bird and a set of walls, generate the set of input values it "senses" from its
-// environment. This is then passed to the bird's brain to determine whether it should jump
-Bird::Array generateBirdInputs(const Bird &bird, const std::vector<Wall> &walls) {
-	// Birds receive the following inputs:
-	// 1. The bird's height relative to the top of the screen
-	// 2. The bird's vertical velocity
-	// 3. The distance to the next wall
-	// 4. The y position of the next wall's gap
-	// 5. The closest wall's horizontal velocity
+// Everything the birds need to know about the walls on a given tick. Every bird has the same x
+// position and size, so the walls a bird can hit and the wall it senses are the same for the whole
+// population. They are found once per tick, leaving each bird with an O(1) interval test and no
+// rectangles to build.
+struct WorldQuery {
+	double ceiling; // Smallest y a bird can be at without hitting the world's top or a wall
+	double floor;	// Largest y a bird can be at without hitting the world's bottom or a wall
+
+	// The sensor inputs describing the closest wall ahead, already mapped into [-1, 1]
+	Scalar wallDistance;
+	Scalar wallGapPosition;
+	Scalar wallVelocity;
+};
 
-	if (!bird.alive()) { return {}; }
+// Find the walls overlapping the birds horizontally and the closest wall ahead of them. The walls
+// are ordered from left to right, so the search stops at the first wall beyond the birds
+WorldQuery queryWorld(const BirdPopulation &birds, const WallRing &walls,
+					  const WorldBounds &bounds) {
+	const double left	= birds.x();
+	const double right	= birds.x() + birds.birdSize().x();
+	const double height = birds.birdSize().y();
 
-	// Find the closest wall
-	int64_t closestWallIndex   = 0;
-	double closestWallDistance = DBL_MAX;
+	WorldQuery query;
+	query.ceiling = 0;
+	query.floor	  = bounds.height - height;
+
+	int64_t closestWallIndex = -1;
 	for (int64_t i = 0; i < walls.size(); ++i) {
-		if (walls[i].position().x() < closestWallDistance &&
-			walls[i].position().x() + walls[i].size().x() > bird.position().x()) {
-			closestWallIndex	= i;
-			closestWallDistance = walls[i].position().x();
-		}
+		const double wallLeft  = walls[i].position().x();
+		const double wallRight = wallLeft + walls[i].size().x();
+
+		// Skip the walls the birds have already passed. The first one left is the closest
+		if (wallRight <= left) { continue; }
+		if (closestWallIndex < 0) { closestWallIndex = i; }
+		if (wallLeft >= right) { break; }
+
+		// A bird overlapping a wall must fit entirely inside its gap
+		const double gapTop	   = walls[i].size().y();
+		const double gapBottom = gapTop + walls[i].gapHeight();
+		query.ceiling		   = std::max(query.ceiling, gapTop);
+		query.floor			   = std::min(query.floor, gapBottom - height);
 	}
 
-	const auto &closest = walls[closestWallIndex];
-
 	// Map the values into a sensible range
-	double birdHeight	= librapid::map(bird.position().y(), 0, surge::window.height(), -1, 1);
-	double birdVelocity = librapid::map(bird.velocity(), -10, 10, -1, 1);
-	double wallDist =
-	  librapid::map(closest.position().x() - bird.position().x(), 0, surge::window.width(), -1, 1);
-	double wallGapPosition = librapid::map(closest.size().y(), 0, surge::window.height(), -1, 1);
-	double wallVelocity	   = librapid::map(closest.velocity().x(), -10, 10, -1, 1);
-
-	return librapid::Array<Scalar, Backend>::fromData({static_cast<Scalar>(birdHeight),
-													   static_cast<Scalar>(birdVelocity),
-													   static_cast<Scalar>(wallDistance),
-													   static_cast<Scalar>(wallGapPosition),
-													   static_cast<Scalar>(wallVelocity)});
+	const auto &closest = walls[std::max<int64_t>(closestWallIndex, 0)];
+	query.wallDistance =
+	  static_cast<Scalar>(librapid::map(closest.position().x() - left, 0, bounds.width, -1, 1));
+	query.wallGapPosition =
+	  static_cast<Scalar>(librapid::map(closest.size().y(), 0, bounds.height, -1, 1));
+	query.wallVelocity =
+	  static_cast<Scalar>(librapid::map(closest.velocity().x(), -10, 10, -1, 1));
+
+	return query;
 }
 
-int64_t updateBirds(std::vector<Bird> &birds, const std::vector<Wall> &walls) {
-	int64_t alive = 0;
-
-	for (auto &bird : birds) {
-		if (!bird.alive()) { continue; }
-
-		// Set the bird's acceleration so that it falls under gravity
-		bird.acceleration() = GRAVITY;
-		bird.update();
+// Generate the set of input values a bird "senses" from its environment and write them to
+// `inputs`. This is then passed to the bird's brain to determine whether it should jump
+void generateBirdInputs(const BirdPopulation &birds, int64_t index, const WorldQuery &query,
+						const WorldBounds &bounds, Scalar *inputs) {
+	// Birds receive the following inputs:
+	// 1. The bird's height relative to the top of the screen
+	// 2. The bird's vertical velocity
+	// 3. The distance to the next wall
+	// 4. The y position of the next wall's gap
+	// 5. The closest wall's horizontal velocity
+	//
+	// The last three are the same for every bird, so they are taken from the world query
+	double birdHeight	= librapid::map(birds.y(index), 0, bounds.height, -1, 1);
+	double birdVelocity = librapid::map(birds.velocity(index), -10, 10, -1, 1);
+
+	inputs[0] = static_cast<Scalar>(birdHeight);
+	inputs[1] = static_cast<Scalar>(birdVelocity);
+	inputs[2] = query.wallDistance;
+	inputs[3] = query.wallGapPosition;
+	inputs[4] = query.wallVelocity;
+}
 
-		// Check for collisions with the ceiling and floor
-		if (bird.position().y() < 0 ||
-			bird.position().y() + bird.size().y() > surge::window.height()) {
-			bird.kill(wallDistance);
-		}
+// When the birds' brains are evaluated. Each bird is only evaluated once every `interval` ticks,
+// and keeps repeating its last decision (to jump or not) in between. The birds are staggered, so
+// bird i is evaluated on the ticks where (tick + i) is a multiple of the interval, and each tick
+// evaluates an even share of the population rather than all of it at once. An interval of 1
+// evaluates every bird on every tick. `substeps` is the number of physics steps in each tick
+struct DecisionSchedule {
+	int64_t interval = 1;
+	int64_t substeps = 1;
+	int64_t tick	 = 0; // The tick being simulated
+
+	[[nodiscard]] bool due(int64_t bird) const { return (tick + bird) % interval == 0; }
+};
 
-		// Check for collisions with the walls
-		for (const auto &wall : walls) {
-			auto [upper, lower] = wall.rectangles();
-			if (rectIntersection(bird.rectangle(), upper) ||
-				rectIntersection(bird.rectangle(), lower)) {
-				bird.kill(wallDistance);
-			}
-		}
+// Advance the living birds at positions [begin, end) of the population's active list by one tick,
+// killing any that hit the world's bounds or a wall (as described by this tick's world query), and
+// let each survivor's brain decide whether to jump. Birds are killed with the given
+// fitness (the distance travelled so far). Nothing is drawn here, so this can be called without a
+// window. The survivors are compacted to the start of the range and their number is returned.
+//
+// The brains of the survivors due a decision (see DecisionSchedule) are evaluated together in a
+// single batch once every bird in the range has moved, reading their genomes from `genomes`. Every
+// survivor then acts on its latest decision. Only the birds in the range are touched, so disjoint
+// ranges can be updated on different threads. The range must lie within one episode, whose first
+// bird is `firstBird` (see episodes.hpp).
+int64_t updateBirds(BirdPopulation &birds, const GenomeArena<Gene> &genomes,
+					const WorldQuery &query, const WorldBounds &bounds, double distance,
+					PopulationBrain<Scalar> &brains, int64_t begin, int64_t end,
+					int64_t firstBird = 0, const DecisionSchedule &schedule = {}) {
+	// Move every bird at once and check for collisions with the ceiling, floor and walls
+	int64_t alive;
+	{
+		PROFILE_PHASE(Phase::Physics);
+		alive = birds.step(
+		  begin, end, GRAVITY, query.ceiling, query.floor, distance, schedule.substeps);
+	}
 
-		// Assuming the bird is alive, generate a set of inputs and give it to the bird's brain.
-		// If the resulting output is greater than 0.5, the bird jumps
-		if (bird.alive()) {
-			auto inputs = generateBirdInputs(bird, walls);
-			auto output = bird.brain().forward(inputs);
-			if (output(0) > 0.5) { bird.jump(); }
-			bird.draw();
-			++alive;
+	const int64_t *active = birds.active() + begin;
+	int64_t *batch		  = brains.batch() + begin;
+
+	// Generate a set of inputs for every surviving bird due a decision and add it to the batch
+	int64_t due = 0;
+	{
+		PROFILE_PHASE(Phase::Sensors);
+		for (int64_t k = 0; k < alive; ++k) {
+			if (!schedule.due(active[k])) { continue; }
+			generateBirdInputs(birds, active[k], query, bounds, brains.inputs(active[k]));
+			batch[due++] = active[k];
 		}
 	}
 
-	// The best bird from the previous generation is always put in the first position of the array,
-	// so draw it a different colour. It is drawn last so that it is always on top
-	birds[0].draw(surge::Color::red);
+	// Evaluate the brains in the batch at once and make the birds jump where necessary
+	PROFILE_PHASE(Phase::Inference);
+	brains.forward(genomes, begin, due, firstBird);
+	const auto &jump = brains.jump();
+	for (int64_t k = 0; k < alive; ++k) {
+		if (jump[active[k]]) { birds.jump(active[k]); }
+	}
 
 	return alive;
 }
 
-// Create a default bird instance without a brain
-Bird createBird() {
-	return {
-	  librapid::Vec2d(30, 30), librapid::Vec2d(50, surge::window.height() / 2), 0, 0, worldSpeed};
+// Create a population of birds without brains, all starting halfway up the world
+BirdPopulation createBirds(int64_t numBirds, const WorldBounds &bounds) {
+	BirdPopulation birds(numBirds, librapid::Vec2d(BIRD_SIZE, BIRD_SIZE), BIRD_X, worldSpeed);
+	birds.reset(bounds.height / 2);
+	return birds;
 }
@@ -12,11 +12,12 @@ public:
 	size_t m_nodes; // Number of nodes in the layer
 	Array m_weight; // Weight matrix
 	Array m_bias;	// Bias vector
-	Array m_buffer; // A temporary buffer to increase performance
+	Array m_buffer; // The layer's outputs, reused by every forward pass
 };
 
-// A simple neural network implementation
-template<typename Scalar, typename Backend>
+// A simple neural network implementation. Every layer uses the same activation function (see
+// activation.hpp)
+template<typename Scalar, typename Backend, typename ActivationFunction = SigmoidActivation>
 class Brain {
 public:
 	using Array = librapid::Array<Scalar, Backend>;
@@ -41,34 +42,43 @@ public:
 
 	// At this point, we assume no more layers will be added, so we can initialize the matrices
 	// and vectors for each layer.
-	void construct() {
+	void construct(Random &random) {
+		allocateBuffers();
 		for (size_t i = 0; i < m_layers.size() - 1; ++i) {
 			m_layers[i].m_weight =
 			  Array(librapid::Shape({m_layers[i + 1].m_nodes, m_layers[i].m_nodes}));
-			m_layers[i].m_bias	 = Array(librapid::Shape({m_layers[i + 1].m_nodes}));
-			m_layers[i].m_buffer = Array(librapid::Shape({m_layers[i + 1].m_nodes}));
+			m_layers[i].m_bias = Array(librapid::Shape({m_layers[i + 1].m_nodes}));
 
 			// Each weight matrix and bias vector is initialized with
 			// random values between -1 and 1
-			librapid::fillRandom(m_layers[i].m_weight, -1.0, 1.0);
-			librapid::fillRandom(m_layers[i].m_bias, -1.0, 1.0);
+			for (auto &weight : m_layers[i].m_weight.storage()) { weight = random.uniform(-1, 1); }
+			for (auto &bias : m_layers[i].m_bias.storage()) { bias = random.uniform(-1, 1); }
 		}
 	}
 
-	// Propagate an input vector through the neural network, returning the output
-	[[nodiscard]] Array forward(const Array &inputs) {
-		m_layers[0].m_buffer = inputs;
-		for (size_t i = 0; i < m_layers.size() - 1; ++i) {
-			const auto &layer		 = m_layers[i];
-
-			// Dot the weight matrix with the previous layer's output
-			m_layers[i + 1].m_buffer = librapid::dot(layer.m_weight, layer.m_buffer);
-
-			// Add the bias vector
-			m_layers[i + 1].m_buffer += layer.m_bias;
+	// Propagate an input vector through the neural network, returning the output. Every layer's
+	// outputs are written into its preallocated buffer, so this never allocates. The result is
+	// only valid until the next call
+	[[nodiscard]] const Array &forward(const Array &inputs) {
+		const auto &input = inputs.storage();
+		std::copy(input.begin(), input.end(), m_layers[0].m_buffer.storage().begin());
 
-			// Apply the activation function
-			m_activation.forward(m_layers[i + 1].m_buffer, m_layers[i + 1].m_buffer);
+		for (size_t i = 0; i < m_layers.size() - 1; ++i) {
+			const auto &layer	= m_layers[i];
+			const auto &weights = layer.m_weight.storage();
+			const auto &bias	= layer.m_bias.storage();
+			const auto &in		= layer.m_buffer.storage();
+			auto &out			= m_layers[i + 1].m_buffer.storage();
+
+			// Dot the weight matrix with the previous layer's output, add the bias vector and
+			// apply the activation function
+			for (size_t row = 0; row < m_layers[i + 1].m_nodes; ++row) {
+				Scalar sum = bias[row];
+				for (size_t col = 0; col < layer.m_nodes; ++col) {
+					sum += weights[row * layer.m_nodes + col] * in[col];
+				}
+				out[row] = ActivationFunction::apply(sum);
+			}
 		}
 
 		return m_layers.back().m_buffer;
@@ -86,31 +96,44 @@ public:
 			brain.m_layers.push_back(newLayer);
 		}
 
-		brain.m_activation = m_activation;
-
+		brain.allocateBuffers();
 		return brain;
 	}
 
 	// Mutate the brain's weights and biases with a given probability (the learning rate).
 	// The learning rate is a value in the range [0, 1], and represents the probability that a given
 	// weight or bias value is mutated. When mutated, a value is changed to a new random value.
-	void mutate(double learningRate) {
+	// Random values are drawn from the given generator, so each thread can mutate its own brains
+	void mutate(double learningRate, Random &random) {
 		for (auto &layer : m_layers) {
 			for (int64_t i = 0; i < layer.m_weight.shape().size(); ++i) {
-				if (librapid::random<double>(0.0, 1.0) < learningRate) {
-					layer.m_weight.storage()[i] = librapid::random<double>(-1.0, 1.0);
+				if (random.uniform() < learningRate) {
+					layer.m_weight.storage()[i] = random.uniform(-1.0, 1.0);
 				}
 			}
 
 			for (int64_t i = 0; i < layer.m_bias.shape().size(); ++i) {
-				if (librapid::random<double>(0.0, 1.0) < learningRate) {
-					layer.m_bias.storage()[i] = librapid::random<double>(-1.0, 1.0);
+				if (random.uniform() < learningRate) {
+					layer.m_bias.storage()[i] = random.uniform(-1.0, 1.0);
 				}
 			}
 		}
 	}
 
+	[[nodiscard]] const std::vector<Layer<Array>> &layers() const { return m_layers; }
+
+	// The number of nodes in each layer, from the input layer to the output layer
+	[[nodiscard]] std::vector<size_t> topology() const {
+		std::vector<size_t> res;
+		for (const auto &layer : m_layers) { res.push_back(layer.m_nodes); }
+		return res;
+	}
+
 private:
+	// Give every layer a buffer for its outputs
+	void allocateBuffers() {
+		for (auto &layer : m_layers) { layer.m_buffer = Array(librapid::Shape({layer.m_nodes})); }
+	}
+
 	std::vector<Layer<Array>> m_layers;
-	librapid::ml::Sigmoid m_activation;
 };
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#	define FLAPPY_BIRD_HAS_MMAP
+#endif
+
+// The binary checkpoint format. A checkpoint file is laid out as:
+//
+//   CheckpointHeader
+//   uint64_t topology[layers]             Number of nodes in each layer
+//   uint64_t randoms[randoms][4]          State of each worker's random stream, then the world's
+//   double fitness[population]            Fitness of the generation the genomes were bred from
+//   Scalar scales[population][layers - 1] Scale of each layer of each genome (see GenomeArena)
+//   (padding up to genomeOffset)
+//   Gene genomes[population][parameters]
+//
+// All values are stored in the machine's native byte order. The genomes start on a 64-byte
+// boundary, so a memory-mapped file can be read without any unaligned accesses.
+struct CheckpointHeader {
+	static constexpr std::array<char, 8> expectedMagic = {'F', 'B', 'A', 'I', 'C', 'K', 'P', 'T'};
+	static constexpr uint32_t currentVersion			= 2;
+
+	std::array<char, 8> magic; // Identifies the file as a checkpoint
+	uint32_t version;		   // Format version. Bump this whenever the layout changes
+	uint32_t geneSize;		   // sizeof(Gene) when the checkpoint was written (see gene.hpp)
+	int64_t population;		   // Number of genomes
+	int64_t parameters;		   // Number of weights and biases in each genome
+	int64_t layers;			   // Number of layers in the topology
+	int64_t randoms;		   // Number of random stream states
+	int64_t generation;		   // Generation number of the stored genomes
+	int64_t ticks;			   // Ticks simulated before the checkpoint
+	double mutationRate;	   // Learning rate
+	uint64_t courseSeed;	   // Seed of the course the stored generation runs on
+	uint64_t fixedCourse;	   // Whether every generation replays the same course
+	uint64_t genomeOffset;	   // Offset of the genomes from the start of the file
+};
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader>);
+
+// Writes checkpoints on a background thread, so saving a large population doesn't stall the tick
+// loop. Everything, including the genomes, is copied into the writer's own buffers when a save
+// starts, so the caller can carry on changing its genomes (e.g. letting in migrants, or respawning
+// birds in steady state) straight away. The buffers are reused, so only the first save allocates.
+class CheckpointWriter {
+public:
+	CheckpointWriter() = default;
+
+	CheckpointWriter(const CheckpointWriter &other)			   = delete;
+	CheckpointWriter &operator=(const CheckpointWriter &other) = delete;
+
+	~CheckpointWriter() { wait(); }
+
+	// Start writing a checkpoint to `path`, waiting for any save already in progress to finish
+	// first. The file is written under a temporary name and renamed once complete, so a crash
+	// part-way through never leaves a corrupt checkpoint behind. There must be one fitness value
+	// for every genome. Returns false (and writes nothing) if there isn't
+	bool save(const std::string &path, const CheckpointHeader &header,
+			  const std::vector<size_t> &topology, const std::vector<Random> &randoms,
+			  const Random &world, const std::vector<double> &fitness, const Gene *genomes,
+			  const Scalar *scales) {
+		wait();
+
+		if (static_cast<int64_t>(fitness.size()) != header.population) {
+			fmt::print(fmt::fg(fmt::color::red),
+					   "Unable to write checkpoint '{}': {} fitness values for {} genomes\n",
+					   path,
+					   fitness.size(),
+					   header.population);
+			return false;
+		}
+
+		m_path	 = path;
+		m_header = header;
+		m_topology.assign(topology.begin(), topology.end());
+		m_randoms.resize(randoms.size() + 1);
+		for (size_t i = 0; i < randoms.size(); ++i) { m_randoms[i] = randoms[i].state(); }
+		m_randoms.back() = world.state();
+		m_fitness.assign(fitness.begin(), fitness.end());
+		m_genomes.assign(genomes, genomes + header.population * header.parameters);
+		m_scales.assign(scales, scales + header.population * (header.layers - 1));
+
+		m_thread = std::thread([this]() { write(); });
+		return true;
+	}
+
+	// Wait for the save in progress, if any, to finish
+	void wait() {
+		if (m_thread.joinable()) { m_thread.join(); }
+	}
+
+private:
+	void write() const {
+		std::string temporary = m_path + ".tmp";
+		std::FILE *file		  = std::fopen(temporary.c_str(), "wb");
+		if (!file) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to write checkpoint '{}'\n", temporary);
+			return;
+		}
+
+		const size_t genomeBytes = m_header.population * m_header.parameters * sizeof(Gene);
+		const size_t tableBytes	 = sizeof(m_header) + m_topology.size() * sizeof(uint64_t) +
+								  m_randoms.size() * sizeof(Random::State) +
+								  m_fitness.size() * sizeof(double) +
+								  m_scales.size() * sizeof(Scalar);
+
+		bool ok = std::fwrite(&m_header, sizeof(m_header), 1, file) == 1;
+		ok		= ok && writeAll(file, m_topology.data(), m_topology.size());
+		ok		= ok && writeAll(file, m_randoms.data(), m_randoms.size());
+		ok		= ok && writeAll(file, m_fitness.data(), m_fitness.size());
+		ok		= ok && writeAll(file, m_scales.data(), m_scales.size());
+		ok		= ok && writePadding(file, m_header.genomeOffset - tableBytes);
+		ok		= ok && std::fwrite(m_genomes.data(), 1, genomeBytes, file) == genomeBytes;
+		ok		= (std::fclose(file) == 0) && ok;
+
+		if (!ok || std::rename(temporary.c_str(), m_path.c_str()) != 0) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to write checkpoint '{}'\n", m_path);
+			std::remove(temporary.c_str());
+		}
+	}
+
+	template<typename T>
+	static bool writeAll(std::FILE *file, const T *data, size_t count) {
+		return std::fwrite(data, sizeof(T), count, file) == count;
+	}
+
+	// Write `bytes` zero bytes, a chunk at a time
+	static bool writePadding(std::FILE *file, size_t bytes) {
+		static const std::array<char, 64> padding {};
+		while (bytes > 0) {
+			const size_t chunk = std::min(bytes, padding.size());
+			if (!writeAll(file, padding.data(), chunk)) { return false; }
+			bytes -= chunk;
+		}
+		return true;
+	}
+
+	std::string m_path;
+	CheckpointHeader m_header {};
+	std::vector<uint64_t> m_topology;
+	std::vector<Random::State> m_randoms;
+	std::vector<double> m_fitness;
+	std::vector<Gene> m_genomes;
+	std::vector<Scalar> m_scales;
+
+	std::thread m_thread;
+};
+
+// The offset of the genomes in a checkpoint with the given sizes, rounded up to 64 bytes
+uint64_t checkpointGenomeOffset(int64_t layers, int64_t randoms, int64_t population) {
+	uint64_t offset = sizeof(CheckpointHeader) + layers * sizeof(uint64_t) +
+					  randoms * sizeof(Random::State) + population * sizeof(double) +
+					  population * (layers - 1) * sizeof(Scalar);
+	return (offset + 63) / 64 * 64;
+}
+
+// Create the header for a checkpoint of a population with the given sizes
+CheckpointHeader createCheckpointHeader(int64_t population, int64_t parameters, int64_t layers,
+										int64_t randoms) {
+	CheckpointHeader header {};
+	header.magic		= CheckpointHeader::expectedMagic;
+	header.version		= CheckpointHeader::currentVersion;
+	header.geneSize		= sizeof(Gene);
+	header.population	= population;
+	header.parameters	= parameters;
+	header.layers		= layers;
+	header.randoms		= randoms;
+	header.genomeOffset = checkpointGenomeOffset(layers, randoms, population);
+	return header;
+}
+
+// A read-only view of a whole file. Where possible the file is memory-mapped, so nothing is read
+// from disk until it is touched and the data is copied straight from the page cache. On platforms
+// without mmap, the file is read into memory instead.
+class MappedFile {
+public:
+	explicit MappedFile(const std::string &path) {
+#if defined(FLAPPY_BIRD_HAS_MMAP)
+		int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) { return; }
+
+		struct stat info {};
+		if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+			void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (data != MAP_FAILED) {
+				madvise(data, info.st_size, MADV_SEQUENTIAL);
+				m_data = static_cast<const char *>(data);
+				m_size = info.st_size;
+			}
+		}
+
+		close(descriptor);
+#else
+		std::FILE *file = std::fopen(path.c_str(), "rb");
+		if (!file) { return; }
+
+		std::fseek(file, 0, SEEK_END);
+		long size = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+
+		if (size > 0) {
+			m_buffer.resize(size);
+			if (std::fread(m_buffer.data(), 1, size, file) == size) {
+				m_data = m_buffer.data();
+				m_size = size;
+			}
+		}
+
+		std::fclose(file);
+#endif
+	}
+
+	MappedFile(const MappedFile &other)			   = delete;
+	MappedFile &operator=(const MappedFile &other) = delete;
+
+	~MappedFile() {
+#if defined(FLAPPY_BIRD_HAS_MMAP)
+		if (m_data) { munmap(const_cast<char *>(m_data), m_size); }
+#endif
+	}
+
+	[[nodiscard]] bool valid() const { return m_data != nullptr; }
+	[[nodiscard]] const char *data() const { return m_data; }
+	[[nodiscard]] size_t size() const { return m_size; }
+
+private:
+	const char *m_data = nullptr;
+	size_t m_size	   = 0;
+
+#if !defined(FLAPPY_BIRD_HAS_MMAP)
+	std::vector<char> m_buffer;
+#endif
+};
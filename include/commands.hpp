@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+
+// A change requested by the interface and applied by the simulation thread between ticks
+struct Command {
+	enum class Type {
+		SetMutationRate,	 // Set the learning rate of every island to `value`
+		SetTickRate,		 // Limit the simulation to `value` ticks per second (0 for no limit)
+		SetTickBudget,		 // End each generation after `value` ticks (0 for no limit)
+		SetSteadyState,		 // Replace genomes as soon as they die if `value` is non-zero
+		SetRecordReplays,	 // Record the elite of each generation if `value` is non-zero
+		SetDecisionInterval, // Evaluate each bird's brain every `value` ticks
+		SetSubsteps,		 // Split the physics of each tick into `value` steps
+		SetRecordTelemetry	 // Log the statistics of each generation if `value` is non-zero
+	};
+
+	Type type;
+	double value;
+};
+
+// A fixed-size, lock-free queue of commands from the interface (the only producer) to the
+// simulation thread (the only consumer). Like MigrationQueue, the two ends only synchronise
+// through a pair of atomic counters, so the interface never waits for a tick to finish and the
+// simulation never waits for a frame to be drawn.
+class CommandQueue {
+public:
+	explicit CommandQueue(int64_t capacity = 256) : m_capacity(capacity), m_commands(capacity) {}
+
+	CommandQueue(const CommandQueue &other)			   = delete;
+	CommandQueue &operator=(const CommandQueue &other) = delete;
+
+	// Add a command to the queue. Returns false (and drops the command) if the queue is full
+	bool push(const Command &command) {
+		const int64_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= m_capacity) { return false; }
+
+		m_commands[tail % m_capacity] = command;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Take the oldest command from the queue. Returns false if the queue is empty
+	bool pop(Command &command) {
+		const int64_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+
+		command = m_commands[head % m_capacity];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	[[nodiscard]] int64_t capacity() const { return m_capacity; }
+
+private:
+	int64_t m_capacity; // Number of commands the queue can hold
+	std::vector<Command> m_commands;
+
+	alignas(64) std::atomic<int64_t> m_head {0}; // Number of commands popped so far
+	alignas(64) std::atomic<int64_t> m_tail {0}; // Number of commands pushed so far
+};
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <surge/surge.hpp>
+#include <thread>
 
 static constexpr double GRAVITY							= 0.125;			// Bird gravity
 static constexpr int64_t NUM_BIRDS						= 5000;			// Number of birds
 static constexpr int64_t NUM_WALLS						= 10;				// Number of walls
 static constexpr double BIRD_JUMP_VELOCITY				= 4.8;				// Jump power
+static constexpr double BIRD_SIZE						= 30;				// Size of a bird
+static constexpr double BIRD_X							= 50;				// Bird x position
 static constexpr double WALL_GAP_SIZE					= 200;				// Opening in a wall
 static constexpr double WALL_WIDTH						= 75;				// Width of a wall
 static constexpr double WALL_SPACING					= WALL_WIDTH + 300; // Space between walls
@@ -14,19 +17,56 @@ static constexpr double WALL_ACCELERATION				= 0.0005; // Acceleration of the wa
 static constexpr double WALL_BUFFER						= 25;  // Gap will never be higher than this
 static constexpr double WALL_SPEED_DISTANCE_COEFFICIENT = 1.1; // Walls move apart as they speed up
 static constexpr double MAX_WALL_SPEED					= 50;  // Fastest the walls can go
+static constexpr double WORLD_WIDTH						= 1000; // Width of the world (and window)
+static constexpr double WORLD_HEIGHT					= 600;	// Height of the world (and window)
+static constexpr uint64_t RANDOM_SEED					= 1234;	 // Seed for the simulation's RNGs
+static constexpr int64_t NUM_ISLANDS					= 1;	 // Independent populations
+static constexpr int64_t MIGRATION_INTERVAL				= 5;	 // Generations between migrations
+static constexpr int64_t NUM_MIGRANTS					= 10;	 // Genomes sent in each migration
+static constexpr int64_t NUM_EPISODES					= 1;	 // Courses each genome flies
+static constexpr int64_t STEADY_STATE_COURSE_TICKS		= 20000; // Steady-state tick budget
 
-static double generationStartTime = 0; // Time the generation started
-static double worldSpeed		  = 1; // Global speed modifier
-static int64_t generationNumber	  = 0; // Current generation number
+static double worldSpeed = 1; // Global speed modifier
+static int64_t numThreads = std::thread::hardware_concurrency(); // Simulation worker threads
 // static double mutationRate		  = 0.1; // Learning/mutation rate
-static float mutationRate  = 0.075; // Learning/mutation rate
-static double wallDistance = 0;		// Distance traveled by the walls (used for fitness)
+static constexpr float mutationRate = 0.075; // Default learning/mutation rate
 
 using Scalar  = float;					// Scalar type for computations
 using Backend = librapid::backend::CPU; // Backend for librapid
 
 #include "utils.hpp"
+#include "gene.hpp"
+#include "random.hpp"
+#include "profiler.hpp"
+#include "allocations.hpp"
+#include "course.hpp"
+#include "mutation.hpp"
+#include "thread_pool.hpp"
+#include "activation.hpp"
 #include "brain.hpp"
+#include "static_brain.hpp"
+
+// The brain used by every bird. StaticBrain has its topology fixed at compile time, so it never
+// allocates and its forward pass is fully unrolled. The population's genomes are stored in the
+// GenomeArena using the same layout as a StaticBrain's parameters, so this must be a StaticBrain
+// (Brain, the librapid implementation, is only kept for comparison in the benchmarks)
+using BirdBrain = StaticBrain<Scalar, SigmoidActivation, 5, 8, 5, 1>;
+
+#include "genome_arena.hpp"
+#include "population_brain.hpp"
 #include "wall.hpp"
 #include "bird.hpp"
+#include "renderer.hpp"
+#include "selection.hpp"
+#include "episodes.hpp"
 #include "generation.hpp"
+#include "migration.hpp"
+#include "checkpoint.hpp"
+#include "replay.hpp"
+#include "telemetry.hpp"
+#include "simulation.hpp"
+#include "commands.hpp"
+#include "islands.hpp"
+#include "triple_buffer.hpp"
+#include "snapshot.hpp"
+#include "simulation_thread.hpp"
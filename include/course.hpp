@@ -0,0 +1,43 @@
+#pragma once
+
+// A seeded, endless sequence of wall gap positions. The position of the i-th wall's gap depends
+// only on the seed and on i, so the same course can be replayed exactly in any later generation,
+// on any thread, or in another run, just by reusing the seed.
+//
+// Each position is a fraction in [0, 1) of the range the gap can be placed in, so a course doesn't
+// depend on the size of the world. The first few thousand are precomputed into a compact array of
+// floats; any beyond that (for birds that survive a very long time) are computed on demand.
+class Course {
+public:
+	static constexpr int64_t defaultLength = 4096; // Number of gaps precomputed by default
+
+	Course() : Course(0) {}
+
+	explicit Course(uint64_t seed, int64_t length = defaultLength) : m_gaps(length) {
+		reseed(seed);
+	}
+
+	// Replace the course with the one generated from a different seed. No memory is allocated
+	void reseed(uint64_t seed) {
+		m_seed = seed;
+		for (size_t i = 0; i < m_gaps.size(); ++i) { m_gaps[i] = compute(i); }
+	}
+
+	// The position of the i-th wall's gap, as a fraction of the range it can be placed in
+	[[nodiscard]] float gap(int64_t index) const {
+		return index < static_cast<int64_t>(m_gaps.size()) ? m_gaps[index] : compute(index);
+	}
+
+	[[nodiscard]] uint64_t seed() const { return m_seed; }
+	[[nodiscard]] int64_t length() const { return m_gaps.size(); }
+
+private:
+	// Hash the seed and index into 24 random bits, which a float holds exactly
+	[[nodiscard]] float compute(int64_t index) const {
+		uint64_t bits = splitMix64(m_seed + (index + 1) * 0x9e3779b97f4a7c15);
+		return static_cast<float>(bits >> 40) * 0x1.0p-24f;
+	}
+
+	uint64_t m_seed = 0;
+	std::vector<float> m_gaps; // The precomputed start of the course
+};
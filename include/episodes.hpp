@@ -0,0 +1,42 @@
+#pragma once
+
+// How the fitness values from a genome's episodes are combined into its fitness
+enum class FitnessAggregation {
+	Mean, // The average over every episode
+	Min	  // The worst episode, which favours genomes that never fail badly
+};
+
+// A single run through a course is a noisy measure of how good a genome is, so each genome can be
+// evaluated on several independent courses (episodes) at once. Every episode has its own walls and
+// its own copy of every bird, and they all advance in lockstep, one tick at a time.
+//
+// The birds are stored episode by episode: bird `episode * genomes + genome` is the copy of
+// `genome` flying through `episode`. Each episode's birds are therefore contiguous and share a
+// single world query, and the whole population is still one structure of arrays which is stepped
+// in a single pass.
+
+// The seed of an episode's course. The first episode uses the base seed itself, so a simulation
+// with one episode runs exactly the same courses as one without episodes
+uint64_t episodeCourseSeed(uint64_t seed, int64_t episode) {
+	return episode == 0 ? seed : splitMix64(seed + episode);
+}
+
+// Combine the fitness of every bird (stored episode by episode) into the fitness of each genome
+void aggregateFitness(const std::vector<double> &birdFitness, int64_t episodes,
+					  FitnessAggregation aggregation, std::vector<double> &fitness) {
+	const int64_t genomes = birdFitness.size() / episodes;
+	fitness.assign(birdFitness.begin(), birdFitness.begin() + genomes);
+
+	for (int64_t episode = 1; episode < episodes; ++episode) {
+		const double *values = birdFitness.data() + episode * genomes;
+		if (aggregation == FitnessAggregation::Min) {
+			for (int64_t i = 0; i < genomes; ++i) { fitness[i] = std::min(fitness[i], values[i]); }
+		} else {
+			for (int64_t i = 0; i < genomes; ++i) { fitness[i] += values[i]; }
+		}
+	}
+
+	if (aggregation == FitnessAggregation::Mean && episodes > 1) {
+		for (double &value : fitness) { value /= static_cast<double>(episodes); }
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+
+#if defined(__F16C__)
+#	include <immintrin.h>
+#endif
+
+// The genes (weights and biases) of every genome are stored as `Gene`, which can be smaller than
+// Scalar. Mutation only ever produces values between -1 and 1, so full precision isn't needed to
+// store them, and a smaller gene lets more genomes fit in the caches and in memory. Genes are
+// converted to Scalar as they are read by the brains, and back again as they are mutated.
+//
+// Configure with -DFLAPPY_BIRD_GENE=half or -DFLAPPY_BIRD_GENE=int8 to choose the gene type:
+//
+//   float  4 bytes. Exactly the values produced by mutation (the default)
+//   half   2 bytes. IEEE 754 half precision, with 11 significant bits
+//   int8   1 byte. A signed integer multiplied by a scale for each layer of each genome, so each
+//          layer's genes are quantised to 255 evenly spaced values across its range
+
+// A 16-bit IEEE 754 half-precision float. The conversions use the F16C instructions where the
+// compiler targets them (e.g. with -march=native on x86), and are done in software otherwise
+struct Half {
+	uint16_t bits = 0;
+
+	Half() = default;
+	explicit Half(float value) : bits(fromFloat(value)) {}
+
+	explicit operator float() const { return toFloat(bits); }
+
+	// Round a float to the nearest half, with ties to even
+	static uint16_t fromFloat(float value) {
+#if defined(__F16C__)
+		return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+		const uint32_t x		= std::bit_cast<uint32_t>(value);
+		const uint32_t sign		= (x >> 16) & 0x8000;
+		const int32_t exponent	= static_cast<int32_t>((x >> 23) & 0xff) - 127 + 15;
+		const uint32_t mantissa = x & 0x7fffff;
+
+		if (((x >> 23) & 0xff) == 0xff) { return sign | 0x7c00 | (mantissa ? 0x200 : 0); }
+		if (exponent >= 31) { return sign | 0x7c00; }
+
+		// Too small for a normal half, so store it as a subnormal (or zero)
+		if (exponent <= 0) {
+			if (exponent < -10) { return sign; }
+			const uint32_t full		 = mantissa | 0x800000;
+			const uint32_t shift	 = 14 - exponent;
+			uint32_t half			 = full >> shift;
+			const uint32_t remainder = full & ((1u << shift) - 1);
+			const uint32_t halfway	 = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1))) { ++half; }
+			return sign | half;
+		}
+
+		// A carry out of the mantissa correctly rounds up into the exponent
+		uint32_t half			 = sign | (exponent << 10) | (mantissa >> 13);
+		const uint32_t remainder = mantissa & 0x1fff;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) { ++half; }
+		return half;
+#endif
+	}
+
+	static float toFloat(uint16_t half) {
+#if defined(__F16C__)
+		return _cvtsh_ss(half);
+#else
+		const uint32_t sign		= static_cast<uint32_t>(half & 0x8000) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1f;
+		const uint32_t mantissa = half & 0x3ff;
+
+		if (exponent == 0) {
+			const float value = std::ldexp(static_cast<float>(mantissa), -24);
+			return sign ? -value : value;
+		}
+		if (exponent == 31) { return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13)); }
+		return std::bit_cast<float>(sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+#endif
+	}
+};
+
+static_assert(sizeof(Half) == 2);
+
+// Converts genes to and from Scalar. `scale` is the scale of the gene's layer, which only the
+// quantised types (those with `scaled` set) use. calibrate() chooses the scale of a layer whose
+// largest absolute value is `absMax`, and fits() checks whether a value can be stored in a layer
+// without being clamped
+template<typename Gene>
+struct GeneCodec {
+	static constexpr bool scaled		 = false;
+	static constexpr Scalar defaultScale = 1;
+
+	static Scalar decode(Gene gene, Scalar) { return static_cast<Scalar>(gene); }
+	static Gene encode(double value, Scalar) { return static_cast<Gene>(value); }
+	static Scalar calibrate(Scalar) { return defaultScale; }
+	static bool fits(double, Scalar) { return true; }
+};
+
+template<>
+struct GeneCodec<Half> {
+	static constexpr bool scaled		 = false;
+	static constexpr Scalar defaultScale = 1;
+
+	static Scalar decode(Half gene, Scalar) { return static_cast<Scalar>(float(gene)); }
+	static Half encode(double value, Scalar) { return Half(static_cast<float>(value)); }
+	static Scalar calibrate(Scalar) { return defaultScale; }
+	static bool fits(double, Scalar) { return true; }
+};
+
+template<>
+struct GeneCodec<int8_t> {
+	// Every gene is between -1 and 1, so by default -127 to 127 covers exactly that range
+	static constexpr bool scaled		 = true;
+	static constexpr Scalar defaultScale = Scalar(1) / Scalar(127);
+
+	static Scalar decode(int8_t gene, Scalar scale) { return static_cast<Scalar>(gene) * scale; }
+
+	// Values outside the layer's range are clamped to it
+	static int8_t encode(double value, Scalar scale) {
+		return static_cast<int8_t>(std::clamp(std::round(value / scale), -127.0, 127.0));
+	}
+
+	// Spread the 255 values evenly over the layer's range, so its largest value is stored exactly
+	static Scalar calibrate(Scalar absMax) {
+		return absMax > 0 ? absMax / Scalar(127) : defaultScale;
+	}
+
+	static bool fits(double value, Scalar scale) { return std::abs(value) <= 127.0 * scale; }
+};
+
+// The gene type, chosen when the project is configured
+#if defined(FLAPPY_BIRD_GENE_HALF)
+using Gene = Half;
+#elif defined(FLAPPY_BIRD_GENE_INT8)
+using Gene = int8_t;
+#else
+using Gene = Scalar;
+#endif
@@ -1,56 +1,40 @@
 #pragma once
 
-// Return the best bird in the generation (the one with the highest fitness)
-std::pair<Bird::BirdBrain, double>
-bestBird(const std::vector<std::pair<Bird::BirdBrain, double>> &brains) {
-	auto best = brains.front();
-	for (const auto &brain : brains) {
-		if (brain.second > best.second) { best = brain; }
+// Return the index of the best bird in the generation (the one with the highest fitness)
+int64_t bestBird(const std::vector<double> &fitness) {
+	int64_t best = 0;
+	for (size_t i = 0; i < fitness.size(); ++i) {
+		if (fitness[i] > fitness[best]) { best = i; }
 	}
 	return best;
 }
 
-// Select a parent for a new bird, weighting the selection towards those with higher fitness values
-std::pair<Bird::BirdBrain, double>
-selectParent(const std::vector<std::pair<Bird::BirdBrain, double>> &brains) {
-	// Calculate the total fitness of the generation
-	double totalFitness = 0.0;
-	for (const auto &brain : brains) { totalFitness += brain.second; }
-	auto targetFitness = librapid::random<double>(0.0, totalFitness);
-
-	// Find the bird which contains the target fitness value
-	double currentFitness = 0.0;
-	for (const auto &brain : brains) {
-		currentFitness += brain.second;
-		if (currentFitness >= targetFitness) { return brain; }
-	}
-
-	return brains.back();
-}
-
-// Produce a new generation of mutated bird brains
-std::vector<Bird::BirdBrain>
-newGeneration(const std::vector<std::pair<Bird::BirdBrain, double>> &brains) {
-	std::vector<Bird::BirdBrain> newBrains;
-	newBrains.reserve(brains.size());
-
-	for (auto &_ : brains) {
-		// Select the parent brain
-		auto parent = selectParent(brains);
-
-		// Copy the brain (each pair is a brain and its fitness)
-		Bird::BirdBrain newBrain = parent.first.copy();
-
-		// Mutate the brain
-		newBrain.mutate(mutationRate);
-
-		newBrains.push_back(newBrain);
-	}
+// Breed a new generation of mutated bird brains into the arena's back buffer, then make it the
+// current generation. Each child is a copy of its parent's genome, so no memory is allocated. The
+// selector's tables are built once, then the children are bred in parallel, with each worker
+// drawing from its own random stream and mutating its whole block of children in one pass
+void newGeneration(GenomeArena<Gene> &genomes, const std::vector<double> &fitness,
+				   ParentSelector &selector, const MutationEngine &mutation, float mutationRate,
+				   ThreadPool &pool, std::vector<Random> &randoms) {
+	selector.prepare(fitness);
+
+	pool.parallelFor(genomes.population(), [&](int64_t begin, int64_t end, int64_t worker) {
+		// Select the parents and copy their genomes into the children
+		for (int64_t i = begin; i < end; ++i) {
+			genomes.reproduce(selector.select(randoms[worker]), i);
+		}
+
+		// Mutate the children
+		mutation.mutate(genomes.nextRow(begin),
+						genomes.nextScales(begin),
+						end - begin,
+						genomes.parameters(),
+						mutationRate,
+						randoms[worker]);
+	});
 
 	// Keep the best bird from the previous generation to prevent the birds getting worse between
 	// generations
-	auto best	 = bestBird(brains);
-	newBrains[0] = best.first.copy();
-
-	return newBrains;
+	genomes.reproduce(bestBird(fitness), 0);
+	genomes.swap();
 }
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstring>
+
+// Every genome (the weights and biases of a brain) in the population, stored in one flat
+// [bird][parameter] buffer. Each row uses the same layout as StaticBrain's parameter array.
+//
+// Genes are stored as `Gene` (see gene.hpp), which may be a quantised type. Each genome has one
+// scale for every layer, calibrated from the largest absolute weight or bias in the layer, which is
+// passed to GeneCodec whenever one of the layer's genes is converted to or from Scalar. The scales
+// are stored in a second [bird][layer] buffer, and travel with their genome wherever it is copied.
+//
+// The arena is double buffered: the next generation is bred into the back buffer while the current
+// generation is still being read, and the two are swapped once breeding is finished. Reproduction
+// is therefore a row memcpy from parent to child, and a generation turnover never allocates.
+template<typename Gene>
+class GenomeArena {
+public:
+	GenomeArena() = default;
+
+	// Create an arena for genomes with the given layer sizes, using StaticBrain's layout (each
+	// layer's weights followed by its biases)
+	GenomeArena(int64_t population, const std::vector<size_t> &topology) :
+			m_population(population), m_layers(topology.size() - 1) {
+		m_layerOffsets.push_back(0);
+		for (size_t i = 0; i < topology.size() - 1; ++i) {
+			m_parameters += topology[i] * topology[i + 1] + topology[i + 1];
+			m_layerOffsets.push_back(m_parameters);
+		}
+
+		for (int64_t i = 0; i < 2; ++i) {
+			m_buffers[i].resize(population * m_parameters);
+			m_scales[i].resize(population * m_layers, GeneCodec<Gene>::defaultScale);
+		}
+	}
+
+	// The genome of a bird in the current generation
+	[[nodiscard]] const Gene *row(int64_t index) const {
+		return m_buffers[m_current].data() + index * m_parameters;
+	}
+
+	Gene *row(int64_t index) { return m_buffers[m_current].data() + index * m_parameters; }
+
+	// The genome of a bird in the generation currently being bred
+	Gene *nextRow(int64_t index) {
+		return m_buffers[1 - m_current].data() + index * m_parameters;
+	}
+
+	// The scale of each layer of a bird's genome in the current generation
+	[[nodiscard]] const Scalar *scales(int64_t index) const {
+		return m_scales[m_current].data() + index * m_layers;
+	}
+
+	Scalar *scales(int64_t index) { return m_scales[m_current].data() + index * m_layers; }
+
+	// The scale of each layer of a bird's genome in the generation currently being bred
+	Scalar *nextScales(int64_t index) {
+		return m_scales[1 - m_current].data() + index * m_layers;
+	}
+
+	// Copy a parent's genome from the current generation into a child's slot in the next one
+	void reproduce(int64_t parent, int64_t child) {
+		std::memcpy(nextRow(child), row(parent), m_parameters * sizeof(Gene));
+		std::memcpy(nextScales(child), scales(parent), m_layers * sizeof(Scalar));
+	}
+
+	// Copy a genome bred into the back buffer into the same slot of the current generation
+	void promote(int64_t index) {
+		std::memcpy(row(index), nextRow(index), m_parameters * sizeof(Gene));
+		std::memcpy(scales(index), nextScales(index), m_layers * sizeof(Scalar));
+	}
+
+	// Make the generation that was being bred the current one
+	void swap() { m_current = 1 - m_current; }
+
+	// Copy a brain's weights and biases into a bird's genome in the current generation, calibrating
+	// each layer's scale to fit its largest value
+	template<typename BrainType>
+	void store(int64_t index, const BrainType &brain) {
+		using Codec = GeneCodec<Gene>;
+
+		Gene *genes	   = row(index);
+		Scalar *layers = scales(index);
+		for (int64_t layer = 0; layer < m_layers; ++layer) {
+			const int64_t begin = m_layerOffsets[layer];
+			const int64_t end	= m_layerOffsets[layer + 1];
+
+			Scalar absMax = 0;
+			for (int64_t i = begin; i < end; ++i) {
+				absMax = std::max(absMax, std::abs(brain.parameters()[i]));
+			}
+
+			layers[layer] = Codec::calibrate(absMax);
+			for (int64_t i = begin; i < end; ++i) {
+				genes[i] = Codec::encode(brain.parameters()[i], layers[layer]);
+			}
+		}
+	}
+
+	// Create a brain from a bird's genome in the current generation
+	template<typename BrainType>
+	[[nodiscard]] BrainType load(int64_t index) const {
+		BrainType brain;
+		const Gene *genes	 = row(index);
+		const Scalar *layers = scales(index);
+		for (int64_t layer = 0; layer < m_layers; ++layer) {
+			for (int64_t i = m_layerOffsets[layer]; i < m_layerOffsets[layer + 1]; ++i) {
+				brain.parameters()[i] = GeneCodec<Gene>::decode(genes[i], layers[layer]);
+			}
+		}
+		return brain;
+	}
+
+	[[nodiscard]] int64_t population() const { return m_population; }
+	[[nodiscard]] int64_t parameters() const { return m_parameters; }
+	[[nodiscard]] int64_t layers() const { return m_layers; }
+
+	// The whole current generation, one genome after another
+	[[nodiscard]] const std::vector<Gene> &data() const { return m_buffers[m_current]; }
+	std::vector<Gene> &data() { return m_buffers[m_current]; }
+
+	// The layer scales of the whole current generation, one genome after another
+	[[nodiscard]] const std::vector<Scalar> &scaleData() const { return m_scales[m_current]; }
+	std::vector<Scalar> &scaleData() { return m_scales[m_current]; }
+
+private:
+	int64_t m_population = 0; // Number of genomes in each generation
+	int64_t m_parameters = 0; // Number of weights and biases in each genome
+	int64_t m_layers	 = 0; // Number of layers (with weights) in each genome
+	int64_t m_current	 = 0; // Index of the buffer holding the current generation
+
+	std::vector<int64_t> m_layerOffsets; // Offset of each layer's first gene, then the total
+	std::array<std::vector<Gene>, 2> m_buffers;
+	std::array<std::vector<Scalar>, 2> m_scales; // Scale of each genome's layers, in each buffer
+};
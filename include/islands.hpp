@@ -0,0 +1,177 @@
+#pragma once
+
+// A summary of one island's progress, safe to read from any thread
+struct IslandSummary {
+	int64_t generation;	 // Generations completed
+	int64_t ticks;		 // Ticks simulated across every generation
+	double lastDistance; // Distance survived in the last completed generation
+	double bestDistance; // Furthest distance survived in any generation
+	int64_t migrantsIn;	 // Genomes received from the previous island
+	int64_t migrantsOut; // Genomes sent to the next island
+};
+
+// Several independent populations (islands), each with its own walls, random streams, generation
+// counter and thread pool, evolving side by side. Every `interval` generations, each island sends
+// copies of its fittest genomes to the next island in a ring through a lock-free MigrationQueue, so
+// good solutions spread between islands while each island keeps its own diversity.
+//
+// Islands can be run on background threads with start(), or advanced manually with tick() and
+// nextGeneration() (e.g. from the render loop, so that one island can be drawn). Since the islands
+// run at their own pace, migrants arrive at slightly different times from run to run. Settings are
+// changed by sending a Command to each island's CommandQueue, which its thread applies between
+// ticks, so no island's state is ever touched by another thread.
+class IslandModel {
+public:
+	IslandModel(const WorldBounds &bounds, int64_t numIslands, int64_t birdsPerIsland,
+				uint64_t seed = RANDOM_SEED, int64_t threadsPerIsland = 1,
+				int64_t interval = MIGRATION_INTERVAL, int64_t migrants = NUM_MIGRANTS,
+				int64_t episodes = NUM_EPISODES) :
+			m_interval(interval),
+			m_migrants(migrants), m_stats(std::max<int64_t>(numIslands, 1)) {
+		for (int64_t i = 0; i < static_cast<int64_t>(m_stats.size()); ++i) {
+			m_islands.push_back(std::make_unique<Simulation>(
+			  bounds, birdsPerIsland, seed + i, threadsPerIsland, episodes));
+			m_queues.push_back(std::make_unique<MigrationQueue<Gene>>(
+			  migrants * 2, BirdBrain::numParameters, BirdBrain::numLayers - 1));
+			m_commands.push_back(std::make_unique<CommandQueue>());
+		}
+	}
+
+	IslandModel(const IslandModel &other)			 = delete;
+	IslandModel &operator=(const IslandModel &other) = delete;
+
+	~IslandModel() { stop(); }
+
+	// Run every island from `first` onwards on its own background thread, until stop() is called.
+	// Islands before `first` are left for the caller to advance. Returns false without starting
+	// anything if there are several islands and one of them uses steady-state replacement, since
+	// its tick() never returns 0 and so it would never reach nextGeneration() to exchange migrants
+	bool start(int64_t first = 0) {
+		for (int64_t i = 0; i < size(); ++i) {
+			if (size() > 1 && m_islands[i]->steadyState()) {
+				fmt::print(fmt::fg(fmt::color::red),
+						   "Island {} uses steady-state replacement, which can't migrate\n",
+						   i);
+				return false;
+			}
+		}
+
+		m_running = true;
+		for (int64_t i = first; i < size(); ++i) {
+			m_threads.emplace_back([this, i]() {
+				while (m_running.load(std::memory_order_relaxed)) {
+					applyCommands(i);
+					if (tick(i) == 0) { nextGeneration(i); }
+				}
+			});
+		}
+		return true;
+	}
+
+	// Stop and join every background thread
+	void stop() {
+		m_running = false;
+		for (auto &thread : m_threads) { thread.join(); }
+		m_threads.clear();
+	}
+
+	// Queue a change to an island running on a background thread, to be applied before its next
+	// tick. Returns false if the island's queue is full
+	bool send(int64_t index, const Command &command) { return m_commands[index]->push(command); }
+
+	// Apply every change sent to an island since its last tick
+	void applyCommands(int64_t index) {
+		Command command {};
+		while (m_commands[index]->pop(command)) {
+			switch (command.type) {
+				case Command::Type::SetMutationRate: {
+					m_islands[index]->setMutationRate(static_cast<float>(command.value));
+					break;
+				}
+				default: break;
+			}
+		}
+	}
+
+	// Advance an island by a single tick and return the number of its birds still alive. The
+	// generation counter is published here too, since in steady state it goes up partway through
+	// a tick rather than in nextGeneration()
+	int64_t tick(int64_t index) {
+		int64_t alive = m_islands[index]->tick();
+		m_stats[index].ticks.store(m_islands[index]->ticks(), std::memory_order_relaxed);
+		m_stats[index].generation.store(m_islands[index]->generation(), std::memory_order_relaxed);
+		return alive;
+	}
+
+	// Record the results of an island's generation, exchange migrants if it is time to, and breed
+	// its next generation
+	void nextGeneration(int64_t index) {
+		auto &island = *m_islands[index];
+		auto &stats	 = m_stats[index];
+
+		double distance = island.distance();
+		stats.lastDistance.store(distance, std::memory_order_relaxed);
+		if (distance > stats.bestDistance.load(std::memory_order_relaxed)) {
+			stats.bestDistance.store(distance, std::memory_order_relaxed);
+		}
+
+		// Send the elites to the next island in the ring, then breed the next generation and let
+		// in any elites that have arrived from the previous island
+		bool migrate = size() > 1 && (island.generation() + 1) % m_interval == 0;
+		if (migrate) {
+			stats.migrantsOut.fetch_add(island.emigrate(*m_queues[index], m_migrants),
+										std::memory_order_relaxed);
+		}
+
+		island.nextGeneration();
+
+		if (size() > 1) {
+			stats.migrantsIn.fetch_add(island.immigrate(*m_queues[(index + size() - 1) % size()]),
+									   std::memory_order_relaxed);
+		}
+
+		stats.generation.store(island.generation(), std::memory_order_relaxed);
+	}
+
+	// The progress of an island so far
+	[[nodiscard]] IslandSummary summary(int64_t index) const {
+		const auto &stats = m_stats[index];
+		return {stats.generation.load(std::memory_order_relaxed),
+				stats.ticks.load(std::memory_order_relaxed),
+				stats.lastDistance.load(std::memory_order_relaxed),
+				stats.bestDistance.load(std::memory_order_relaxed),
+				stats.migrantsIn.load(std::memory_order_relaxed),
+				stats.migrantsOut.load(std::memory_order_relaxed)};
+	}
+
+	// An island's simulation. Only touch an island running on a background thread once stopped
+	[[nodiscard]] const Simulation &island(int64_t index) const { return *m_islands[index]; }
+	Simulation &island(int64_t index) { return *m_islands[index]; }
+
+	[[nodiscard]] int64_t size() const { return m_islands.size(); }
+	[[nodiscard]] int64_t interval() const { return m_interval; }
+	[[nodiscard]] int64_t migrants() const { return m_migrants; }
+
+private:
+	// Each island's statistics are written by the thread running it and read by anyone, so every
+	// value is atomic and each island's values are on their own cache line
+	struct alignas(64) Stats {
+		std::atomic<int64_t> generation {0};
+		std::atomic<int64_t> ticks {0};
+		std::atomic<double> lastDistance {0};
+		std::atomic<double> bestDistance {0};
+		std::atomic<int64_t> migrantsIn {0};
+		std::atomic<int64_t> migrantsOut {0};
+	};
+
+	int64_t m_interval; // Generations between migrations
+	int64_t m_migrants; // Genomes sent in each migration
+
+	std::vector<std::unique_ptr<Simulation>> m_islands;
+	std::vector<std::unique_ptr<MigrationQueue<Gene>>> m_queues; // Queue i goes to island i + 1
+	std::vector<std::unique_ptr<CommandQueue>> m_commands;		 // Changes sent to each island
+	std::vector<Stats> m_stats;
+
+	std::vector<std::thread> m_threads;
+	std::atomic<bool> m_running {false};
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+// A fixed-size, lock-free queue of genomes migrating from one island to another. Each queue has
+// exactly one producer (the island sending migrants) and one consumer (the island receiving them),
+// so the two ends only ever synchronise through a pair of atomic counters and never block. The
+// genomes, along with the scales of their layers (see GenomeArena), are copied into preallocated
+// slots, so pushing and popping never allocate.
+//
+// If the receiving island falls behind and the queue fills up, new migrants are dropped rather
+// than making the sender wait.
+template<typename Gene>
+class MigrationQueue {
+public:
+	MigrationQueue(int64_t capacity, int64_t parameters, int64_t layers) :
+			m_capacity(capacity), m_parameters(parameters), m_layers(layers),
+			m_genomes(capacity * parameters), m_scales(capacity * layers), m_fitness(capacity) {}
+
+	MigrationQueue(const MigrationQueue &other)			   = delete;
+	MigrationQueue &operator=(const MigrationQueue &other) = delete;
+
+	// Copy a genome and its layers' scales into the queue. Returns false (and drops the genome) if
+	// the queue is full
+	bool push(const Gene *genome, const Scalar *scales, double fitness) {
+		const int64_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= m_capacity) { return false; }
+
+		const int64_t slot = tail % m_capacity;
+		std::copy_n(genome, m_parameters, m_genomes.data() + slot * m_parameters);
+		std::copy_n(scales, m_layers, m_scales.data() + slot * m_layers);
+		m_fitness[slot] = fitness;
+
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Copy the oldest genome in the queue into `genome` and its layers' scales into `scales`.
+	// Returns false if the queue is empty
+	bool pop(Gene *genome, Scalar *scales, double &fitness) {
+		const int64_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+
+		const int64_t slot = head % m_capacity;
+		std::copy_n(m_genomes.data() + slot * m_parameters, m_parameters, genome);
+		std::copy_n(m_scales.data() + slot * m_layers, m_layers, scales);
+		fitness = m_fitness[slot];
+
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	[[nodiscard]] int64_t capacity() const { return m_capacity; }
+	[[nodiscard]] int64_t parameters() const { return m_parameters; }
+
+private:
+	int64_t m_capacity;	  // Number of genomes the queue can hold
+	int64_t m_parameters; // Number of weights and biases in each genome
+	int64_t m_layers;	  // Number of layer scales with each genome
+
+	std::vector<Gene> m_genomes;
+	std::vector<Scalar> m_scales;
+	std::vector<double> m_fitness;
+
+	// The counters are on separate cache lines so that the two islands don't fight over them
+	alignas(64) std::atomic<int64_t> m_head {0}; // Number of genomes popped so far
+	alignas(64) std::atomic<int64_t> m_tail {0}; // Number of genomes pushed so far
+};
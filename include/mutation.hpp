@@ -0,0 +1,178 @@
+#pragma once
+
+// Call func(index) for each index in [0, count), choosing every index independently with a given
+// probability. Instead of drawing a random number for every index, the gap to the next chosen index
+// is drawn from a geometric distribution, so the cost is proportional to the number of indices
+// chosen rather than to `count`.
+template<typename Func>
+void forEachMutation(int64_t count, double rate, Random &random, Func &&func) {
+	if (rate <= 0 || count <= 0) return;
+
+	if (rate >= 1) {
+		for (int64_t i = 0; i < count; ++i) { func(i); }
+		return;
+	}
+
+	// If U is uniform in (0, 1], floor(log(U) / log(1 - p)) is the number of failures before the
+	// next success in a sequence of Bernoulli(p) trials
+	const double inverseLog = 1.0 / std::log1p(-rate);
+	int64_t index			= -1;
+	while (true) {
+		double skip = std::floor(std::log(1.0 - random.uniform()) * inverseLog);
+		if (skip >= static_cast<double>(count - index - 1)) return;
+		index += static_cast<int64_t>(skip) + 1;
+		func(index);
+	}
+}
+
+// Replace each gene, with a given probability, by a new random value between -1 and 1
+template<typename Scalar>
+void mutateReset(Scalar *genes, int64_t count, double rate, Random &random) {
+	forEachMutation(count, rate, random, [&](int64_t i) {
+		genes[i] = static_cast<Scalar>(random.uniform(-1.0, 1.0));
+	});
+}
+
+// The kinds of mutation which can be applied to a genome
+enum class MutationOperator {
+	Reset,	 // Replace the gene with a new random value
+	Gaussian // Add normally distributed noise to the gene
+};
+
+// Mutates whole blocks of genomes at once. Each genome is split into segments (by default, one
+// for each layer's weights and one for its biases), each with its own rate relative to the global
+// learning rate. Every segment is mutated across every genome in the block in a single sparse pass
+// over the buffer, so the cost is proportional to the number of genes that actually change.
+class MutationEngine {
+public:
+	// A contiguous range of genes within every genome, mutated at `scale` times the learning rate
+	struct Segment {
+		int64_t offset;
+		int64_t size;
+		double scale;
+		int64_t layer; // The layer the genes belong to, which gives their scale in the genome
+	};
+
+	MutationEngine() = default;
+
+	// Create an engine for genomes with the given layer sizes, using StaticBrain's layout (each
+	// layer's weights followed by its biases). Every segment starts at the global learning rate
+	explicit MutationEngine(const std::vector<size_t> &topology) {
+		int64_t offset = 0;
+		for (size_t i = 0; i < topology.size() - 1; ++i) {
+			int64_t weights = topology[i] * topology[i + 1];
+			int64_t biases	= topology[i + 1];
+			m_segments.push_back({offset, weights, 1.0, static_cast<int64_t>(i)});
+			m_segments.push_back({offset + weights, biases, 1.0, static_cast<int64_t>(i)});
+			offset += weights + biases;
+		}
+	}
+
+	// Set the rate of a layer's weights and biases, relative to the global learning rate
+	MutationEngine &setLayerScale(size_t layer, double scale) {
+		m_segments[layer * 2].scale		= scale;
+		m_segments[layer * 2 + 1].scale = scale;
+		return *this;
+	}
+
+	MutationEngine &setOperator(MutationOperator op) {
+		m_operator = op;
+		return *this;
+	}
+
+	// Set the standard deviation and the largest absolute gene value for Gaussian mutation. Values
+	// are clamped so that weights can't run away
+	MutationEngine &setGaussian(double sigma, double limit) {
+		m_sigma = sigma;
+		m_limit = limit;
+		return *this;
+	}
+
+	// Mutate `count` genomes, stored one after another with `stride` genes each, along with the
+	// scales of their layers (see GenomeArena). The genes are changed in place in their stored
+	// form. If a new value is too large for its layer's scale, that layer of that genome is
+	// requantised with a scale calibrated to fit it, so a value is never clamped by the gene type.
+	// Once every gene has been mutated, any layer whose largest value has shrunk is requantised
+	// with a smaller scale, so the scales follow the genes down as well as up
+	template<typename Gene>
+	void mutate(Gene *genomes, Scalar *scales, int64_t count, int64_t stride, double learningRate,
+				Random &random) const {
+		using Codec = GeneCodec<Gene>;
+
+		const int64_t layers = m_segments.size() / 2;
+
+		for (const auto &segment : m_segments) {
+			// Treat the segment of every genome as one long run of genes and skip through it
+			forEachMutation(
+			  count * segment.size, learningRate * segment.scale, random, [&](int64_t index) {
+				  int64_t genome	= index / segment.size;
+				  int64_t parameter = segment.offset + index % segment.size;
+				  Gene *genes		= genomes + genome * stride;
+				  Scalar &scale		= scales[genome * layers + segment.layer];
+
+				  double value;
+				  if (m_operator == MutationOperator::Reset) {
+					  value = random.uniform(-1.0, 1.0);
+				  } else {
+					  value = Codec::decode(genes[parameter], scale) + random.normal() * m_sigma;
+					  value = librapid::clamp(value, -m_limit, m_limit);
+				  }
+
+				  if (!Codec::fits(value, scale)) {
+					  rescale(genes, scale, segment.layer, static_cast<Scalar>(std::abs(value)));
+				  }
+				  genes[parameter] = Codec::encode(value, scale);
+			  });
+		}
+
+		if constexpr (Codec::scaled) {
+			for (int64_t genome = 0; genome < count; ++genome) {
+				for (int64_t layer = 0; layer < layers; ++layer) {
+					shrink(genomes + genome * stride, scales[genome * layers + layer], layer);
+				}
+			}
+		}
+	}
+
+	[[nodiscard]] const std::vector<Segment> &segments() const { return m_segments; }
+	[[nodiscard]] MutationOperator op() const { return m_operator; }
+
+private:
+	// Requantise every gene in a layer of a genome with the scale calibrated for a layer whose
+	// largest absolute value is `absMax`
+	template<typename Gene>
+	void rescale(Gene *genes, Scalar &scale, int64_t layer, Scalar absMax) const {
+		using Codec = GeneCodec<Gene>;
+
+		const Segment &weights = m_segments[layer * 2];
+		const Segment &biases  = m_segments[layer * 2 + 1];
+		const Scalar newScale  = Codec::calibrate(absMax);
+		for (int64_t i = weights.offset; i < biases.offset + biases.size; ++i) {
+			genes[i] = Codec::encode(Codec::decode(genes[i], scale), newScale);
+		}
+		scale = newScale;
+	}
+
+	// Requantise a layer of a genome with the scale calibrated for its largest value, if that is at
+	// least a whole step inside the layer's range (so a layer still using all of it is left alone).
+	// Without this, a scale could only ever grow, and a layer whose largest gene was mutated away
+	// would keep wasting part of its range
+	template<typename Gene>
+	void shrink(Gene *genes, Scalar &scale, int64_t layer) const {
+		using Codec = GeneCodec<Gene>;
+
+		const Segment &weights = m_segments[layer * 2];
+		const Segment &biases  = m_segments[layer * 2 + 1];
+		Scalar absMax		   = 0;
+		for (int64_t i = weights.offset; i < biases.offset + biases.size; ++i) {
+			absMax = std::max(absMax, std::abs(Codec::decode(genes[i], scale)));
+		}
+
+		if (Codec::fits(absMax + scale, scale)) { rescale(genes, scale, layer, absMax); }
+	}
+
+	std::vector<Segment> m_segments;
+	MutationOperator m_operator = MutationOperator::Reset;
+	double m_sigma				= 0.1; // Standard deviation of Gaussian mutations
+	double m_limit				= 1.0; // Largest absolute value a Gaussian mutation can produce
+};
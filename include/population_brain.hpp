@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+// Evaluates the brains of an entire population at once. Calling Brain::forward for every bird runs
+// a chain of tiny matrix-vector products per bird, so instead the inputs of every bird are stacked
+// into a single matrix and each layer is evaluated for a whole batch of birds in a single kernel.
+//
+// The weights are read straight from the population's GenomeArena, where each genome uses
+// StaticBrain's layout. Every layer's weights therefore form a 3D tensor (bird x input x output)
+// with a fixed stride between birds, which the kernel streams through contiguously.
+//
+// The hidden layers' activation can be changed at run time. The kernel is compiled once for each
+// activation (see activation.hpp), so the choice is made once per batch rather than per neuron.
+template<typename Scalar>
+class PopulationBrain {
+public:
+	PopulationBrain() = default;
+
+	PopulationBrain(const std::vector<size_t> &topology, int64_t population) :
+			m_topology(topology), m_population(population) {
+		for (size_t nodes : m_topology) { m_width = std::max(m_width, nodes); }
+
+		// Each layer's weights are followed immediately by its biases
+		size_t offset = 0;
+		for (size_t i = 0; i < m_topology.size() - 1; ++i) {
+			m_weightOffsets.push_back(offset);
+			offset += m_topology[i] * m_topology[i + 1];
+			m_biasOffsets.push_back(offset);
+			offset += m_topology[i + 1];
+		}
+
+		m_inputs.resize(population * m_topology.front());
+		m_indices.resize(population);
+		m_buffers[0].resize(population * m_width);
+		m_buffers[1].resize(population * m_width);
+		m_jump.resize(population);
+	}
+
+	// The row of the input matrix belonging to a given bird
+	Scalar *inputs(int64_t index) { return m_inputs.data() + index * m_topology.front(); }
+
+	// Scratch space for a list of bird indices to evaluate, with room for every bird
+	int64_t *batch() { return m_indices.data(); }
+
+	// Evaluate the brains of the birds listed in batch()[begin, begin + count) and update the jump
+	// mask for each of them. Bird i uses genome i - firstBird, so the birds of a later episode can
+	// share the genomes of the first. Each bird only reads and writes its own rows of the input and
+	// intermediate matrices, so disjoint parts of the batch can be evaluated on different threads.
+	template<typename Gene>
+	void forward(const GenomeArena<Gene> &genomes, int64_t begin, int64_t count,
+				 int64_t firstBird = 0) {
+		dispatchActivation(m_activation, [&](auto activation) {
+			forward<decltype(activation)>(genomes, begin, count, firstBird);
+		});
+	}
+
+	// Evaluate a batch of brains (see above) with a fixed activation function. The genes are
+	// converted to Scalar as they are read, so a quantised genome is never expanded in memory
+	template<typename ActivationFunction, typename Gene>
+	void forward(const GenomeArena<Gene> &genomes, int64_t begin, int64_t count,
+				 int64_t firstBird) {
+		using Codec = GeneCodec<Gene>;
+
+		const int64_t *indices = m_indices.data() + begin;
+		const Scalar *input	   = m_inputs.data();
+		size_t inputWidth	   = m_topology.front();
+
+		for (size_t layer = 0; layer < m_topology.size() - 1; ++layer) {
+			size_t inputs  = m_topology[layer];
+			size_t outputs = m_topology[layer + 1];
+			Scalar *output = m_buffers[layer % 2].data();
+
+			const Gene *weights	 = genomes.row(0) + m_weightOffsets[layer];
+			const Gene *biases	 = genomes.row(0) + m_biasOffsets[layer];
+			const Scalar *scales = genomes.scales(0) + layer;
+			const int64_t stride = genomes.parameters();
+			const int64_t layers = genomes.layers();
+
+			for (int64_t row = 0; row < count; ++row) {
+				int64_t bird	   = indices[row];
+				const Gene *w	   = weights + (bird - firstBird) * stride;
+				const Gene *b	   = biases + (bird - firstBird) * stride;
+				const Scalar scale = scales[(bird - firstBird) * layers];
+				const Scalar *x	   = input + bird * inputWidth;
+				Scalar *y		   = output + bird * m_width;
+
+				for (size_t o = 0; o < outputs; ++o) { y[o] = Codec::decode(b[o], scale); }
+
+				// Broadcast each input across every output
+				for (size_t i = 0; i < inputs; ++i) {
+					const Scalar xi = x[i];
+					for (size_t o = 0; o < outputs; ++o) {
+						y[o] += Codec::decode(w[i * outputs + o], scale) * xi;
+					}
+				}
+
+				// Apply the activation function. The output layer's is skipped, since only the sign
+				// of its pre-activation is needed
+				if (layer + 2 < m_topology.size()) {
+					for (size_t o = 0; o < outputs; ++o) { y[o] = ActivationFunction::apply(y[o]); }
+				}
+			}
+
+			input	   = output;
+			inputWidth = m_width;
+		}
+
+		// The output layer has a single node. If it's above the activation's threshold (or
+		// equivalently, its pre-activation is above 0), the bird jumps
+		for (int64_t row = 0; row < count; ++row) {
+			m_jump[indices[row]] = input[indices[row] * inputWidth] > Scalar(0);
+		}
+	}
+
+	// Choose the activation function of the hidden layers
+	void setActivation(Activation activation) { m_activation = activation; }
+
+	// Forget the last decision of every bird (or of some birds), so that they don't jump again
+	// until they are next evaluated
+	void clearJumps() { std::fill(m_jump.begin(), m_jump.end(), 0); }
+	void clearJumps(const std::vector<int64_t> &birds) {
+		for (int64_t bird : birds) { m_jump[bird] = 0; }
+	}
+
+	// Whether each bird should jump, as of the last time it was evaluated
+	[[nodiscard]] const std::vector<uint8_t> &jump() const { return m_jump; }
+
+	[[nodiscard]] const std::vector<size_t> &topology() const { return m_topology; }
+	[[nodiscard]] int64_t population() const { return m_population; }
+	[[nodiscard]] Activation activation() const { return m_activation; }
+
+private:
+	std::vector<size_t> m_topology; // Number of nodes in each layer
+	int64_t m_population = 0;		// Maximum number of birds that can be evaluated
+	size_t m_width		 = 0;		// Nodes in the widest layer
+
+	// Activation function of the hidden layers
+	Activation m_activation = Activation::Sigmoid;
+
+	std::vector<size_t> m_weightOffsets; // Offset of each layer's weights within a genome
+	std::vector<size_t> m_biasOffsets;	 // Offset of each layer's biases within a genome
+
+	std::vector<Scalar> m_inputs;				  // Stacked inputs: [bird][input]
+	std::vector<int64_t> m_indices;				  // Birds to evaluate
+	std::array<std::vector<Scalar>, 2> m_buffers; // Ping-pong layer outputs: [bird][node]
+	std::vector<uint8_t> m_jump;				  // Jump mask for every bird in the population
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <utility>
+
+// The phases of the program timed by the profiler
+enum class Phase {
+	Walls,		// Moving and recycling the walls
+	Collision,	// Finding the walls the birds can hit (and sense), as a ceiling and floor
+	Physics,	// Moving the birds and testing them against the ceiling and floor
+	Sensors,	// Generating the inputs for the brains
+	Inference,	// Evaluating the brains and jumping
+	Evolution,	// Breeding the next generation
+	Drawing,	// Drawing the walls and birds
+	Interface	// Building the ImGui/ImPlot windows
+};
+
+static constexpr int64_t numPhases = 8;
+
+static constexpr std::array<const char *, numPhases> phaseNames = {
+  "Walls", "Collision", "Physics", "Sensors", "Inference", "Evolution", "Drawing", "Interface"};
+
+// Whether the timers were compiled in. Configure with -DFLAPPY_BIRD_PROFILE=ON to enable them
+#if defined(FLAPPY_BIRD_PROFILE)
+static constexpr bool profilingEnabled = true;
+#else
+static constexpr bool profilingEnabled = false;
+#endif
+
+// The total time spent in, and number of entries into, each phase. The times are summed over
+// every thread, so phases that run on several threads at once can add up to more than the time
+// that actually passed.
+struct PhaseTimes {
+	std::array<uint64_t, numPhases> nanoseconds {};
+	std::array<uint64_t, numPhases> calls {};
+
+	[[nodiscard]] double milliseconds(int64_t phase) const { return nanoseconds[phase] * 1e-6; }
+
+	[[nodiscard]] double totalMilliseconds() const {
+		uint64_t total = 0;
+		for (uint64_t value : nanoseconds) { total += value; }
+		return total * 1e-6;
+	}
+
+	// The time spent in each phase since an earlier snapshot
+	PhaseTimes operator-(const PhaseTimes &earlier) const {
+		PhaseTimes difference;
+		for (int64_t i = 0; i < numPhases; ++i) {
+			difference.nanoseconds[i] = nanoseconds[i] - earlier.nanoseconds[i];
+			difference.calls[i]		  = calls[i] - earlier.calls[i];
+		}
+		return difference;
+	}
+};
+
+// Collects the time spent in each phase. Every thread accumulates into its own slot (on its own
+// cache line), and only the thread owning a slot ever writes to it, so recording a time is two
+// relaxed atomic adds without any contention. Taking a snapshot sums every slot.
+//
+// A thread's slot is allocated the first time it records a time, and pushed onto a lock-free list
+// of every slot. Slots are never removed, so there is no limit on the number of threads, and the
+// time spent by threads that have since finished still counts.
+class Profiler {
+public:
+	static Profiler &instance() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	Profiler() = default;
+
+	Profiler(const Profiler &other)			   = delete;
+	Profiler &operator=(const Profiler &other) = delete;
+
+	~Profiler() {
+		Slot *slot = m_slots.load(std::memory_order_acquire);
+		while (slot) { delete std::exchange(slot, slot->next); }
+	}
+
+	void record(Phase phase, uint64_t nanoseconds) {
+		Slot &slot		 = threadSlot();
+		const auto index = static_cast<int64_t>(phase);
+		slot.nanoseconds[index].fetch_add(nanoseconds, std::memory_order_relaxed);
+		slot.calls[index].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// The total time spent in each phase so far
+	[[nodiscard]] PhaseTimes snapshot() const {
+		PhaseTimes times;
+		for (const Slot *slot = m_slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+			for (int64_t i = 0; i < numPhases; ++i) {
+				times.nanoseconds[i] += slot->nanoseconds[i].load(std::memory_order_relaxed);
+				times.calls[i] += slot->calls[i].load(std::memory_order_relaxed);
+			}
+		}
+		return times;
+	}
+
+private:
+	struct alignas(64) Slot {
+		std::array<std::atomic<uint64_t>, numPhases> nanoseconds {};
+		std::array<std::atomic<uint64_t>, numPhases> calls {};
+		Slot *next = nullptr; // The slot added before this one
+	};
+
+	// The calling thread's slot, which is added to the list the first time it records a time
+	Slot &threadSlot() {
+		thread_local Slot *slot = addSlot();
+		return *slot;
+	}
+
+	Slot *addSlot() {
+		auto *slot = new Slot();
+		slot->next = m_slots.load(std::memory_order_relaxed);
+		while (!m_slots.compare_exchange_weak(
+		  slot->next, slot, std::memory_order_release, std::memory_order_relaxed)) {}
+		return slot;
+	}
+
+	std::atomic<Slot *> m_slots {nullptr}; // The most recently added slot
+};
+
+// Records the time between its construction and destruction against a phase
+class ScopedTimer {
+public:
+	explicit ScopedTimer(Phase phase) : m_phase(phase), m_start(Clock::now()) {}
+
+	ScopedTimer(const ScopedTimer &other)			 = delete;
+	ScopedTimer &operator=(const ScopedTimer &other) = delete;
+
+	~ScopedTimer() {
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+		Profiler::instance().record(m_phase, elapsed.count());
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	Phase m_phase;
+	Clock::time_point m_start;
+};
+
+// Time the rest of the enclosing scope. Without FLAPPY_BIRD_PROFILE this expands to nothing
+#if defined(FLAPPY_BIRD_PROFILE)
+#	define PROFILE_CONCAT_IMPL(a, b) a##b
+#	define PROFILE_CONCAT(a, b)	  PROFILE_CONCAT_IMPL(a, b)
+#	define PROFILE_PHASE(phase)	  ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(phase)
+#else
+#	define PROFILE_PHASE(phase)
+#endif
+
+// The time spent in each phase over the last few frames, for plotting. Each phase is stacked on
+// top of the ones before it, so plotting the area between consecutive rows gives a stacked chart.
+//
+// The frames are kept in ring buffers of a fixed size, so once the history is full each new frame
+// overwrites the oldest one in place. The oldest frame is at offset(), which ImPlot can be given
+// directly to plot the rings in order.
+class PhaseHistory {
+public:
+	explicit PhaseHistory(int64_t capacity) : m_capacity(capacity), m_frames(capacity) {
+		for (auto &row : m_stacked) { row.resize(capacity); }
+	}
+
+	// Add a frame, given the time spent in each phase during it
+	void push(const PhaseTimes &frame) {
+		m_frames[m_next] = static_cast<double>(m_pushed++);
+
+		double total		 = 0;
+		m_stacked[0][m_next] = 0;
+		for (int64_t i = 0; i < numPhases; ++i) {
+			total += frame.milliseconds(i);
+			m_stacked[i + 1][m_next] = total;
+		}
+
+		m_next = (m_next + 1) % m_capacity;
+		m_size = std::min(m_size + 1, m_capacity);
+	}
+
+	// The average time spent in a phase over every frame in the history, in milliseconds
+	[[nodiscard]] double average(int64_t phase) const {
+		if (m_size == 0) { return 0; }
+
+		double sum = 0;
+		for (int64_t i = 0; i < m_size; ++i) {
+			sum += m_stacked[phase + 1][i] - m_stacked[phase][i];
+		}
+		return sum / static_cast<double>(m_size);
+	}
+
+	// The number of frames in the history
+	[[nodiscard]] int64_t size() const { return m_size; }
+
+	// The index of the oldest frame in each ring
+	[[nodiscard]] int64_t offset() const { return m_size == m_capacity ? m_next : 0; }
+
+	// The frame numbers, for the x axis
+	[[nodiscard]] const std::vector<double> &frames() const { return m_frames; }
+
+	// The total time spent in every phase before `phase` in each frame. stacked(numPhases) is the
+	// total time spent in every phase
+	[[nodiscard]] const std::vector<double> &stacked(int64_t phase) const {
+		return m_stacked[phase];
+	}
+
+private:
+	int64_t m_capacity;	  // Number of frames to remember
+	int64_t m_size	 = 0; // Number of frames in the history so far
+	int64_t m_next	 = 0; // Index the next frame is written to
+	int64_t m_pushed = 0; // Number of frames pushed so far
+
+	std::vector<double> m_frames;
+	std::array<std::vector<double>, numPhases + 1> m_stacked;
+};
+
+// Streams the time spent in each phase to a CSV file, one row at a time
+class ProfileLog {
+public:
+	explicit ProfileLog(const std::string &path) : m_file(std::fopen(path.c_str(), "w")) {
+		if (!m_file) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to write profile '{}'\n", path);
+			return;
+		}
+
+		std::string header = "time";
+		for (const char *name : phaseNames) { header += fmt::format(",{} (ms)", name); }
+		std::fputs((header + "\n").c_str(), m_file);
+	}
+
+	ProfileLog(const ProfileLog &other)			   = delete;
+	ProfileLog &operator=(const ProfileLog &other) = delete;
+
+	~ProfileLog() {
+		if (m_file) { std::fclose(m_file); }
+	}
+
+	// Write a row with the time spent in each phase since the last row
+	void write(double time, const PhaseTimes &times) {
+		if (!m_file) { return; }
+
+		std::string row = fmt::format("{}", time);
+		for (int64_t i = 0; i < numPhases; ++i) {
+			row += fmt::format(",{}", times.milliseconds(i));
+		}
+		std::fputs((row + "\n").c_str(), m_file);
+	}
+
+private:
+	std::FILE *m_file;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+
+// Scramble a 64-bit value (the SplitMix64 finalizer). Consecutive inputs give unrelated outputs
+inline uint64_t splitMix64(uint64_t z) {
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+// A small, fast pseudo-random number generator (xoshiro256**). Unlike the global librapid RNG,
+// every instance has its own state, so each worker thread can own a generator and the results of
+// a run only depend on the seed (and the number of threads), not on how the threads interleave.
+class Random {
+public:
+	using State = std::array<uint64_t, 4>;
+
+	Random() : Random(0) {}
+
+	// Seed the generator. The seed is expanded with SplitMix64 so that similar seeds still produce
+	// completely different streams
+	explicit Random(uint64_t seed) {
+		for (auto &word : m_state) {
+			seed += 0x9e3779b97f4a7c15;
+			word = splitMix64(seed);
+		}
+	}
+
+	// Return the next 64 random bits
+	uint64_t next() {
+		const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+		const uint64_t t	  = m_state[1] << 17;
+
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotl(m_state[3], 45);
+
+		return result;
+	}
+
+	// Return a uniformly distributed value in [0, 1)
+	double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+	// Return a uniformly distributed value in [lower, upper)
+	double uniform(double lower, double upper) { return lower + (upper - lower) * uniform(); }
+
+	// Return a normally distributed value with a mean of 0 and a standard deviation of 1
+	double normal() {
+		// Box-Muller transform. 1 - uniform() is in (0, 1], so the logarithm is always finite
+		double radius = std::sqrt(-2.0 * std::log(1.0 - uniform()));
+		return radius * std::cos(2.0 * 3.14159265358979323846 * uniform());
+	}
+
+	// Advance the generator by 2^128 steps. Calling this repeatedly on a copy of a generator
+	// produces non-overlapping streams, one for each worker
+	void jump() {
+		static constexpr State jumpTable = {
+		  0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+		State state {};
+		for (uint64_t word : jumpTable) {
+			for (int bit = 0; bit < 64; ++bit) {
+				if (word & (uint64_t(1) << bit)) {
+					for (size_t i = 0; i < state.size(); ++i) { state[i] ^= m_state[i]; }
+				}
+				next();
+			}
+		}
+
+		m_state = state;
+	}
+
+	[[nodiscard]] const State &state() const { return m_state; }
+	State &state() { return m_state; }
+
+private:
+	static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+	State m_state;
+};
+
+// Create one independent random stream for each worker thread from a single seed
+std::vector<Random> createRandomStreams(uint64_t seed, int64_t numStreams) {
+	std::vector<Random> streams;
+	streams.reserve(numStreams);
+
+	Random random(seed);
+	for (int64_t i = 0; i < numStreams; ++i) {
+		streams.push_back(random);
+		random.jump();
+	}
+
+	return streams;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+// If raylib's rlgl is available, every quad is pushed straight into its vertex batch, so the birds
+// are submitted in a single draw call. Otherwise, each quad is drawn as a surge rectangle
+#if __has_include(<rlgl.h>)
+#	include <rlgl.h>
+#	define FLAPPY_BIRD_HAS_RLGL
+#endif
+
+// How much of the population is drawn
+enum class RenderMode {
+	All,	// Every living bird
+	Sample, // A fixed random sample of the birds
+	Elite,	// Only the best bird from the previous generation
+	Heatmap // The density of living birds at each height
+};
+
+static constexpr std::array<const char *, 4> renderModeNames = {
+  "All", "Sample", "Elite", "Heatmap"};
+
+// Draws the bird population in a single batch, with the number of quads decoupled from the size of
+// the population. Every bird has the same x position and size, so birds at the same pixel row look
+// identical and only one of them needs to be drawn. A frame therefore never contains more birds
+// than the world has rows of pixels, however many birds are alive.
+class BirdRenderer {
+public:
+	BirdRenderer() = default;
+
+	explicit BirdRenderer(const WorldBounds &bounds) :
+			m_rows(static_cast<size_t>(bounds.height) + 1),
+			m_density(static_cast<size_t>(bounds.height / heatmapBinSize) + 1) {}
+
+	void setMode(RenderMode mode) { m_mode = mode; }
+
+	// Set the number of birds drawn in Sample mode
+	void setSampleSize(int64_t size) { m_sampleSize = size; }
+
+	[[nodiscard]] RenderMode mode() const { return m_mode; }
+	[[nodiscard]] int64_t sampleSize() const { return m_sampleSize; }
+
+	// The number of quads drawn in the last frame
+	[[nodiscard]] int64_t quads() const { return m_quads.size(); }
+
+	// Draw the living birds using the current mode. The best bird from the previous generation
+	// (always the first bird) is drawn in red on top in every mode. `birds` can be a BirdPopulation
+	// or a BirdSnapshot
+	template<typename Birds>
+	void draw(const Birds &birds) {
+		m_quads.clear();
+		const auto &size = birds.birdSize();
+
+		switch (m_mode) {
+			case RenderMode::All: {
+				for (int64_t i = 0; i < birds.size(); ++i) { addBirdOnce(birds, i); }
+				break;
+			}
+			case RenderMode::Sample: {
+				updateSample(birds.size());
+				for (int64_t index : m_sample) { addBirdOnce(birds, index); }
+				break;
+			}
+			case RenderMode::Elite: break;
+			case RenderMode::Heatmap: {
+				addHeatmap(birds);
+				break;
+			}
+		}
+
+		if (birds.size() > 0 && birds.alive(0)) {
+			addBird(birds.x(), birds.y(0), size.x(), size.y(), PaletteColor::Red);
+		}
+
+		submit();
+		std::fill(m_rows.begin(), m_rows.end(), 0);
+	}
+
+private:
+	static constexpr double heatmapBinSize = 4; // Height of each heatmap cell, in pixels
+
+	// The colours used by the renderer, from the coolest to the hottest heatmap colour
+	enum PaletteColor : uint8_t { Blue, Cyan, Green, Yellow, Orange, Red };
+
+	static constexpr int64_t paletteSize = 6;
+
+	struct Quad {
+		float x, y, width, height;
+		PaletteColor color;
+	};
+
+	// Add a bird unless a bird in the same pixel row has already been added this frame
+	template<typename Birds>
+	void addBirdOnce(const Birds &birds, int64_t index) {
+		if (!birds.alive(index)) { return; }
+
+		auto row = static_cast<size_t>(std::max(birds.y(index), 0.0));
+		if (row >= m_rows.size() || m_rows[row]) { return; }
+		m_rows[row] = 1;
+
+		addBird(birds.x(), row, birds.birdSize().x(), birds.birdSize().y(), PaletteColor::Cyan);
+	}
+
+	// Add a filled bird with an outline 5 pixels thick
+	void addBird(double x, double y, double width, double height, PaletteColor fill) {
+		constexpr double outline = 5;
+		m_quads.push_back({float(x), float(y), float(width), float(height), PaletteColor::Blue});
+		m_quads.push_back({float(x + outline),
+						   float(y + outline),
+						   float(width - outline * 2),
+						   float(height - outline * 2),
+						   fill});
+	}
+
+	// Add one cell for each band of heights with living birds in it, coloured by how many birds
+	// are in the band on a logarithmic scale
+	template<typename Birds>
+	void addHeatmap(const Birds &birds) {
+		std::fill(m_density.begin(), m_density.end(), 0);
+
+		int64_t maxDensity = 1;
+		for (int64_t i = 0; i < birds.size(); ++i) {
+			if (!birds.alive(i)) { continue; }
+			auto bin = static_cast<size_t>(std::max(birds.y(i), 0.0) / heatmapBinSize);
+			if (bin >= m_density.size()) { continue; }
+			maxDensity = std::max(maxDensity, ++m_density[bin]);
+		}
+
+		const double scale = (paletteSize - 2) / std::log1p(static_cast<double>(maxDensity));
+		for (size_t bin = 0; bin < m_density.size(); ++bin) {
+			if (m_density[bin] == 0) { continue; }
+
+			// Red is kept for the elite, so the heatmap runs from blue to orange
+			auto color = static_cast<PaletteColor>(
+			  std::lround(std::log1p(static_cast<double>(m_density[bin])) * scale));
+			m_quads.push_back({float(birds.x()),
+							   float(bin * heatmapBinSize),
+							   float(birds.birdSize().x()),
+							   float(heatmapBinSize),
+							   color});
+		}
+	}
+
+	// Choose a new random sample of birds if the sample size or population has changed
+	void updateSample(int64_t population) {
+		int64_t size = std::min(m_sampleSize, population);
+		if (static_cast<int64_t>(m_sample.size()) == size && m_samplePopulation == population) {
+			return;
+		}
+
+		// A partial Fisher-Yates shuffle of the bird indices
+		std::vector<int64_t> indices(population);
+		for (int64_t i = 0; i < population; ++i) { indices[i] = i; }
+
+		Random random(RANDOM_SEED);
+		for (int64_t i = 0; i < size; ++i) {
+			auto j = i + static_cast<int64_t>(random.uniform() * (population - i));
+			std::swap(indices[i], indices[std::min(j, population - 1)]);
+		}
+
+		m_sample.assign(indices.begin(), indices.begin() + size);
+		m_samplePopulation = population;
+	}
+
+	// Draw every quad added this frame
+	void submit() const {
+#if defined(FLAPPY_BIRD_HAS_RLGL)
+		static constexpr std::array<std::array<uint8_t, 4>, paletteSize> palette = {{
+		  {0, 121, 241, 255},
+		  {0, 255, 255, 255},
+		  {0, 228, 48, 255},
+		  {253, 249, 0, 255},
+		  {255, 161, 0, 255},
+		  {230, 41, 55, 255},
+		}};
+
+		rlSetTexture(rlGetTextureIdDefault());
+		rlBegin(RL_QUADS);
+		for (const auto &quad : m_quads) {
+			// Flush the batch first if this quad wouldn't fit in it
+			rlCheckRenderBatchLimit(4);
+
+			const auto &color = palette[quad.color];
+			rlColor4ub(color[0], color[1], color[2], color[3]);
+			rlVertex2f(quad.x, quad.y);
+			rlVertex2f(quad.x, quad.y + quad.height);
+			rlVertex2f(quad.x + quad.width, quad.y + quad.height);
+			rlVertex2f(quad.x + quad.width, quad.y);
+		}
+		rlEnd();
+		rlSetTexture(0);
+#else
+		static const std::array<surge::Color, paletteSize> palette = {surge::Color::blue,
+																	  surge::Color::cyan,
+																	  surge::Color::green,
+																	  surge::Color::yellow,
+																	  surge::Color::orange,
+																	  surge::Color::red};
+
+		for (const auto &quad : m_quads) {
+			surge::Rectangle rectangle(librapid::Vec2d(quad.x, quad.y),
+									   librapid::Vec2d(quad.width, quad.height));
+			rectangle.draw(palette[quad.color]);
+		}
+#endif
+	}
+
+	RenderMode m_mode	 = RenderMode::All;
+	int64_t m_sampleSize = 500;
+
+	std::vector<Quad> m_quads;		// The quads to draw this frame
+	std::vector<uint8_t> m_rows;	// Whether a bird has been added at each pixel row this frame
+	std::vector<int64_t> m_density; // Living birds in each band of heights (heatmap)
+	std::vector<int64_t> m_sample;	// The birds drawn in Sample mode
+	int64_t m_samplePopulation = 0; // Population size the sample was chosen from
+};
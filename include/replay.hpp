@@ -0,0 +1,259 @@
+#pragma once
+
+// A replay file is a stream of records, one for each recorded bird in each generation, appended as
+// each generation finishes. Every record is laid out as:
+//
+//   ReplayHeader
+//   uint8_t jumps[(ticks + 7) / 8]       Whether the bird jumped on each tick, one bit per tick
+//
+// The walls only depend on the course seed, and the bird's path only depends on the walls and on
+// when it jumped, so this is all that is needed to re-simulate the bird exactly without its brain
+// or the rest of the population. A whole generation takes one bit per tick to store. The bits are
+// the jumps the bird actually made, so a bird repeating a decision between evaluations (see
+// DecisionSchedule) is stored the same way as one deciding on every tick.
+struct ReplayHeader {
+	static constexpr std::array<char, 8> expectedMagic = {'F', 'B', 'A', 'I', 'R', 'P', 'L', 'Y'};
+	static constexpr uint32_t currentVersion			= 2;
+
+	std::array<char, 8> magic; // Identifies the start of a record
+	uint32_t version;		   // Format version. Bump this whenever the layout changes
+	uint32_t survived;		   // Whether the bird was still alive when its tick budget ran out
+	uint32_t substeps;		   // Physics steps in each tick
+	uint32_t decisionInterval; // Ticks between the bird's decisions (not needed to replay it)
+	uint64_t courseSeed;	   // Seed of the course the bird flew through
+	int64_t generation;		   // Generation the bird was in (starting at 1)
+	int64_t bird;			   // Index of the bird in the population
+	int64_t ticks;			   // Ticks the bird survived, which is the number of jump bits
+	double distance;		   // Distance the bird survived
+};
+
+static_assert(std::is_trivially_copyable_v<ReplayHeader>);
+
+// A single bird's recorded run through a course
+struct ReplayRecord {
+	ReplayHeader header;
+	std::vector<uint8_t> jumps; // One bit per tick, least significant bit first
+
+	[[nodiscard]] bool jumped(int64_t tick) const { return (jumps[tick / 8] >> (tick % 8)) & 1; }
+};
+
+// Records when some of the birds jump on every tick, and appends a record for each of them to a
+// replay file at the end of every generation. The bit buffers are reused between generations
+class ReplayRecorder {
+public:
+	static constexpr size_t initialBytes = 1024; // Jump bits reserved for each bird (8192 ticks)
+
+	ReplayRecorder() { setBirds({0}); }
+
+	ReplayRecorder(const ReplayRecorder &other)			   = delete;
+	ReplayRecorder &operator=(const ReplayRecorder &other) = delete;
+
+	~ReplayRecorder() { close(); }
+
+	// Start appending records to a file. Returns false if the file couldn't be opened
+	bool open(const std::string &path) {
+		close();
+		m_file = std::fopen(path.c_str(), "ab");
+		if (!m_file) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to write replays to '{}'\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	void close() {
+		if (m_file) { std::fclose(m_file); }
+		m_file = nullptr;
+	}
+
+	// Choose which birds to record (by default, only the best bird from the previous generation)
+	void setBirds(const std::vector<int64_t> &birds) {
+		m_birds.assign(birds.begin(), birds.end());
+		m_jumps.resize(m_birds.size());
+		for (auto &jumps : m_jumps) { jumps.reserve(initialBytes); }
+		m_ticks.resize(m_birds.size());
+		m_survived.resize(m_birds.size());
+		clear();
+	}
+
+	// Forget everything recorded in this generation
+	void clear() {
+		for (auto &jumps : m_jumps) { jumps.clear(); }
+		std::fill(m_ticks.begin(), m_ticks.end(), 0);
+		std::fill(m_survived.begin(), m_survived.end(), 0);
+	}
+
+	// Record whether each recorded bird still alive after this tick decided to jump
+	void record(const BirdPopulation &birds, const std::vector<uint8_t> &jump) {
+		if (!m_file) { return; }
+
+		for (size_t i = 0; i < m_birds.size(); ++i) {
+			const int64_t bird = m_birds[i];
+			if (bird >= birds.size() || !birds.alive(bird)) { continue; }
+
+			int64_t &tick = m_ticks[i];
+			if (tick % 8 == 0) { m_jumps[i].push_back(0); }
+			m_jumps[i].back() |= static_cast<uint8_t>((jump[bird] & 1) << (tick % 8));
+			++tick;
+		}
+	}
+
+	// Note which recorded birds are still alive when the generation's tick budget runs out, just
+	// before they are killed
+	void recordSurvivors(const BirdPopulation &birds) {
+		for (size_t i = 0; i < m_birds.size(); ++i) {
+			m_survived[i] = m_birds[i] < birds.size() && birds.alive(m_birds[i]);
+		}
+	}
+
+	// Append a record for each recorded bird to the file, then clear the buffers for the next
+	// generation. Each bird's course seed is found from its episode (see episodes.hpp)
+	void write(const BirdPopulation &birds, int64_t generation, uint64_t courseSeed,
+			   int64_t genomes, const DecisionSchedule &schedule) {
+		if (!m_file) { return; }
+
+		for (size_t i = 0; i < m_birds.size(); ++i) {
+			const int64_t bird = m_birds[i];
+			if (bird >= birds.size()) { continue; }
+
+			ReplayHeader header {};
+			header.magic			= ReplayHeader::expectedMagic;
+			header.version			= ReplayHeader::currentVersion;
+			header.courseSeed		= episodeCourseSeed(courseSeed, bird / genomes);
+			header.generation		= generation;
+			header.bird				= bird;
+			header.survived			= m_survived[i];
+			header.substeps			= static_cast<uint32_t>(schedule.substeps);
+			header.decisionInterval = static_cast<uint32_t>(schedule.interval);
+			header.ticks			= m_ticks[i];
+			header.distance			= std::sqrt(birds.fitness(bird));
+
+			std::fwrite(&header, sizeof(header), 1, m_file);
+			std::fwrite(m_jumps[i].data(), 1, m_jumps[i].size(), m_file);
+
+			// Make room for a run twice as long now, rather than growing the buffer during a tick
+			m_jumps[i].reserve(2 * m_jumps[i].size());
+		}
+
+		// Flush every generation, so a reader never has to wait long for a complete record
+		std::fflush(m_file);
+		clear();
+	}
+
+	[[nodiscard]] bool enabled() const { return m_file != nullptr; }
+	[[nodiscard]] const std::vector<int64_t> &birds() const { return m_birds; }
+
+private:
+	std::FILE *m_file = nullptr;
+
+	std::vector<int64_t> m_birds;			   // The birds being recorded
+	std::vector<std::vector<uint8_t>> m_jumps; // Jump bits of each recorded bird
+	std::vector<int64_t> m_ticks;			   // Ticks recorded for each bird
+	std::vector<uint8_t> m_survived;		   // Whether each bird outlived the tick budget
+};
+
+// Read every complete record from a replay file. A record still being written at the end of the
+// file is ignored. Returns an empty list if the file couldn't be read
+std::vector<ReplayRecord> readReplays(const std::string &path) {
+	std::vector<ReplayRecord> records;
+
+	MappedFile file(path);
+	if (!file.valid()) {
+		fmt::print(fmt::fg(fmt::color::red), "Unable to read replays from '{}'\n", path);
+		return records;
+	}
+
+	size_t offset = 0;
+	while (offset + sizeof(ReplayHeader) <= file.size()) {
+		ReplayRecord record;
+		std::memcpy(&record.header, file.data() + offset, sizeof(ReplayHeader));
+
+		if (record.header.magic != ReplayHeader::expectedMagic ||
+			record.header.version != ReplayHeader::currentVersion || record.header.ticks < 0 ||
+			record.header.substeps < 1) {
+			fmt::print(fmt::fg(fmt::color::red),
+					   "Replay file '{}' is corrupt after {} record(s)\n",
+					   path,
+					   records.size());
+			break;
+		}
+
+		const size_t bytes = (record.header.ticks + 7) / 8;
+		if (offset + sizeof(ReplayHeader) + bytes > file.size()) { break; }
+
+		const char *jumps = file.data() + offset + sizeof(ReplayHeader);
+		record.jumps.assign(jumps, jumps + bytes);
+		records.push_back(std::move(record));
+		offset += sizeof(ReplayHeader) + bytes;
+	}
+
+	return records;
+}
+
+// Re-simulates a single recorded bird and its walls. The bird is moved with exactly the same
+// physics as in the simulation, and jumps whenever it did when it was recorded, so it follows the
+// same path and dies at the same point. One bird and a handful of walls take well under a
+// microsecond a tick, so a whole generation replays in milliseconds.
+class ReplayPlayer {
+public:
+	ReplayPlayer(const WorldBounds &bounds, ReplayRecord record) :
+			m_bounds(bounds), m_record(std::move(record)), m_course(m_record.header.courseSeed),
+			m_walls(NUM_WALLS), m_birds(createBirds(1, bounds)) {
+		resetWalls(m_walls, m_bounds, m_course);
+	}
+
+	// Advance the replay by a single tick. Returns false once the bird has died
+	bool step() {
+		if (m_birds.numActive() == 0) { return false; }
+
+		// The same order as Simulation::tick()
+		updateWalls(m_walls, m_bounds, m_course);
+		m_distance += 0.1;
+
+		WorldQuery query = queryWorld(m_birds, m_walls, m_bounds);
+		m_alive[0] = m_birds.step(
+		  0, 1, GRAVITY, query.ceiling, query.floor, m_distance, m_record.header.substeps);
+		m_birds.mergeActive(m_begin, m_alive);
+		if (m_alive[0] == 0) { return false; }
+
+		// Birds can't jump beyond the end of the recording
+		if (m_tick < m_record.header.ticks && m_record.jumped(m_tick)) { m_birds.jump(0); }
+		++m_tick;
+
+		// A bird that outlived its tick budget was killed straight after its last recorded tick
+		if (m_record.header.survived && m_tick >= m_record.header.ticks) {
+			m_birds.killActive(m_distance);
+			return false;
+		}
+
+		return true;
+	}
+
+	// Play the rest of the replay and return the distance the bird survived
+	double run() {
+		while (step()) {}
+		return distance();
+	}
+
+	// The distance the bird survived, or has survived so far
+	[[nodiscard]] double distance() const {
+		return m_birds.numActive() == 0 ? std::sqrt(m_birds.fitness(0)) : m_distance;
+	}
+
+	[[nodiscard]] const ReplayRecord &record() const { return m_record; }
+	[[nodiscard]] const BirdPopulation &birds() const { return m_birds; }
+	[[nodiscard]] const WallRing &walls() const { return m_walls; }
+	[[nodiscard]] int64_t tick() const { return m_tick; }
+
+private:
+	WorldBounds m_bounds;
+	ReplayRecord m_record;
+	Course m_course;
+	WallRing m_walls;
+	BirdPopulation m_birds; // A population of just the recorded bird
+	double m_distance = 0;	// Distance travelled by the walls
+	int64_t m_tick	  = 0;	// Ticks replayed so far
+
+	std::vector<int64_t> m_begin {0}; // The bird's single chunk, for BirdPopulation::mergeActive()
+	std::vector<int64_t> m_alive {0};
+};
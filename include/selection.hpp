@@ -0,0 +1,137 @@
+#pragma once
+
+// The ways parents can be chosen for the next generation
+enum class SelectionStrategy {
+	Roulette,	// Probability proportional to fitness
+	Tournament, // The fittest of a few birds chosen at random
+	Rank		// Probability proportional to the bird's rank when sorted by fitness
+};
+
+// Chooses parents for the next generation. prepare() is called once per generation and does all of
+// the work which depends on the whole population (building an alias table or sorting by fitness),
+// after which each call to select() takes constant time, no matter how large the population is.
+// select() only reads the prepared state, so it can be called from many threads at once, each with
+// its own random stream. The buffers are reused between generations, so nothing is allocated once
+// the population size stops changing.
+class ParentSelector {
+public:
+	ParentSelector() = default;
+
+	explicit ParentSelector(SelectionStrategy strategy, int64_t tournamentSize = 3) :
+			m_strategy(strategy), m_tournamentSize(tournamentSize) {}
+
+	// Build the lookup tables for a generation with the given fitness values
+	void prepare(const std::vector<double> &fitness) {
+		m_fitness = &fitness;
+
+		switch (m_strategy) {
+			case SelectionStrategy::Roulette: {
+				buildAliasTable(fitness.size(), [&](int64_t i) { return fitness[i]; });
+				break;
+			}
+			case SelectionStrategy::Rank: {
+				// Sort the birds from least to most fit, then weight each one by its rank
+				m_order.resize(fitness.size());
+				for (size_t i = 0; i < m_order.size(); ++i) { m_order[i] = i; }
+				std::sort(m_order.begin(), m_order.end(), [&](int64_t a, int64_t b) {
+					return fitness[a] < fitness[b];
+				});
+				buildAliasTable(fitness.size(),
+								[](int64_t rank) { return static_cast<double>(rank + 1); });
+				break;
+			}
+			case SelectionStrategy::Tournament: break;
+		}
+	}
+
+	// Choose the index of a parent from the prepared generation
+	[[nodiscard]] int64_t select(Random &random) const {
+		const int64_t size = m_fitness->size();
+
+		switch (m_strategy) {
+			case SelectionStrategy::Roulette: return sampleAliasTable(random);
+			case SelectionStrategy::Rank: return m_order[sampleAliasTable(random)];
+			case SelectionStrategy::Tournament: {
+				int64_t best = randomIndex(size, random);
+				for (int64_t i = 1; i < m_tournamentSize; ++i) {
+					int64_t challenger = randomIndex(size, random);
+					if ((*m_fitness)[challenger] > (*m_fitness)[best]) { best = challenger; }
+				}
+				return best;
+			}
+		}
+
+		return 0;
+	}
+
+	// Whether prepare() has been called since the selector was created
+	[[nodiscard]] bool prepared() const { return m_fitness != nullptr; }
+
+	[[nodiscard]] SelectionStrategy strategy() const { return m_strategy; }
+	[[nodiscard]] int64_t tournamentSize() const { return m_tournamentSize; }
+
+private:
+	static int64_t randomIndex(int64_t size, Random &random) {
+		return std::min(static_cast<int64_t>(random.uniform() * size), size - 1);
+	}
+
+	// Build a table for sampling index i with probability weight(i) / sum(weight) in O(1), using
+	// Vose's alias method. If every weight is zero, every index is equally likely
+	template<typename Weight>
+	void buildAliasTable(int64_t size, Weight &&weight) {
+		m_probability.resize(size);
+		m_alias.resize(size);
+		m_small.resize(size);
+		m_large.resize(size);
+
+		double total = 0;
+		for (int64_t i = 0; i < size; ++i) { total += weight(i); }
+
+		// Scale the weights so that they average 1, then split them into those above and below
+		int64_t numSmall = 0;
+		int64_t numLarge = 0;
+		for (int64_t i = 0; i < size; ++i) {
+			m_probability[i] = total > 0 ? weight(i) * size / total : 1.0;
+			if (m_probability[i] < 1.0) {
+				m_small[numSmall++] = i;
+			} else {
+				m_large[numLarge++] = i;
+			}
+		}
+
+		// Fill each under-full slot with the remainder of an over-full one
+		while (numSmall > 0 && numLarge > 0) {
+			int64_t small = m_small[--numSmall];
+			int64_t large = m_large[--numLarge];
+
+			m_alias[small]		 = large;
+			m_probability[large] = (m_probability[large] + m_probability[small]) - 1.0;
+
+			if (m_probability[large] < 1.0) {
+				m_small[numSmall++] = large;
+			} else {
+				m_large[numLarge++] = large;
+			}
+		}
+
+		// Anything left over is (up to rounding error) exactly full
+		while (numLarge > 0) { m_probability[m_large[--numLarge]] = 1.0; }
+		while (numSmall > 0) { m_probability[m_small[--numSmall]] = 1.0; }
+	}
+
+	[[nodiscard]] int64_t sampleAliasTable(Random &random) const {
+		int64_t slot = randomIndex(m_probability.size(), random);
+		return random.uniform() < m_probability[slot] ? slot : m_alias[slot];
+	}
+
+	SelectionStrategy m_strategy = SelectionStrategy::Roulette;
+	int64_t m_tournamentSize	 = 3;
+
+	const std::vector<double> *m_fitness = nullptr; // Fitness of the prepared generation
+
+	std::vector<double> m_probability; // Chance of keeping each slot of the alias table
+	std::vector<int64_t> m_alias;	   // The index used when a slot isn't kept
+	std::vector<int64_t> m_order;	   // Birds sorted by fitness (rank selection)
+	std::vector<int64_t> m_small;	   // Work lists for building the alias table
+	std::vector<int64_t> m_large;
+};
@@ -0,0 +1,678 @@
+#pragma once
+
+// The simulation core. It owns the walls, the bird population and the generation counters, and
+// it never touches surge's window or drawing functions while ticking, so it can run headless as
+// fast as the CPU allows. Rendering is done separately, from snapshots (see SimulationThread).
+//
+// The population is split into one chunk per thread every tick, and each worker thread has its own
+// random stream, so a run is reproducible for a given seed and number of threads. The walls are
+// generated from a seeded Course. By default every generation gets a new course, but the same one
+// can be replayed every generation so that fitness values can be compared between generations.
+//
+// Each genome can also be evaluated on several courses (episodes) at once, with the fitness of its
+// birds in every episode combined into a single value (see episodes.hpp). The episodes advance in
+// lockstep, and the generation ends once every bird in every episode has died.
+//
+// A generation can also be cut short after a fixed number of ticks, with the survivors scored on
+// the distance they have covered so far. Alternatively, in steady-state mode there are no separate
+// generations at all: as soon as a genome's birds have died, it is replaced by a child bred from a
+// pool of recent fitness values and its birds are respawned, so the threads never sit idle while a
+// few strong birds finish a generation on their own.
+//
+// The brains don't have to be evaluated on every tick. With a decision interval of N, each bird
+// decides once every N ticks and repeats its decision in between, with the birds staggered so that
+// every tick evaluates about 1/N of them (see DecisionSchedule). The physics can also be split into
+// several substeps per tick. Either way, the walls move and collisions are checked on every tick.
+//
+// The statistics of every generation can be appended to a telemetry log (see telemetry.hpp).
+class Simulation {
+public:
+	explicit Simulation(const WorldBounds &bounds, int64_t numBirds = NUM_BIRDS,
+						uint64_t seed = RANDOM_SEED, int64_t threads = numThreads,
+						int64_t episodes = NUM_EPISODES) :
+			m_bounds(bounds),
+			m_episodes(std::max<int64_t>(episodes, 1)), m_walls(m_episodes, WallRing(NUM_WALLS)),
+			m_courses(m_episodes), m_queries(m_episodes),
+			m_birds(createBirds(numBirds * m_episodes, bounds)),
+			m_genomes(numBirds, BirdBrain().topology()),
+			m_brains(BirdBrain().topology(), numBirds * m_episodes),
+			m_mutation(BirdBrain().topology()), m_pool(threads), m_workerBegin(m_pool.size()),
+			m_workerAlive(m_pool.size()), m_workerDied(m_pool.size()), m_fitness(numBirds),
+			m_parentFitness(numBirds), m_birthDistance(numBirds), m_checked(numBirds) {
+		m_respawn.reserve(numBirds);
+		m_inherited.reserve(numBirds);
+		m_ranked.reserve(numBirds);
+		m_revive.reserve(m_birds.size());
+
+		// One random stream for each worker, plus one for the world itself
+		m_randoms = createRandomStreams(seed, m_pool.size() + 1);
+		m_random  = m_randoms.back();
+		m_randoms.pop_back();
+
+		resetCourses(m_random.next());
+
+		// Give each bird a random brain
+		m_pool.parallelFor(numBirds, [this](int64_t begin, int64_t end, int64_t worker) {
+			for (int64_t i = begin; i < end; ++i) {
+				m_genomes.store(i, createBirdBrain(m_randoms[worker]));
+			}
+		});
+
+		m_alive				  = m_birds.size();
+		m_generationStartTime = librapid::now();
+		m_statsStartTime	  = m_generationStartTime;
+	}
+
+	// Advance the world by a single tick and return the number of birds still alive
+	int64_t tick() {
+		{
+			PROFILE_PHASE(Phase::Walls);
+			for (int64_t i = 0; i < m_episodes; ++i) {
+				updateWalls(m_walls[i], m_bounds, m_courses[i]);
+			}
+			m_distance += 0.1; // Arbitrary. So long as it's increasing, it's fine.
+		}
+
+		// Every bird in an episode sees the same walls, so find the ceiling and floor they collide
+		// with once for each episode
+		{
+			PROFILE_PHASE(Phase::Collision);
+			for (int64_t i = 0; i < m_episodes; ++i) {
+				m_queries[i] = queryWorld(m_birds, m_walls[i], m_bounds);
+			}
+		}
+
+		// Only the living birds are updated, and every episode is updated in the same pass. The
+		// birds are listed in order, so each episode's birds are contiguous, but a worker's chunk
+		// may span several episodes. It is split where one episode ends and the next begins, and
+		// the survivors (and the dead) of each part are moved up to follow those of the part before
+		const int64_t genomes			= m_genomes.population();
+		const DecisionSchedule schedule = {m_decisionInterval, m_substeps, m_generationTicks};
+		m_pool.parallelFor(m_birds.numActive(), [&](int64_t begin, int64_t end, int64_t worker) {
+			int64_t *active = m_birds.active();
+			int64_t *died	= m_birds.died();
+			int64_t alive	= 0;
+			int64_t dead	= 0;
+			for (int64_t part = begin; part < end;) {
+				const int64_t first = active[part] / genomes * genomes;
+				const int64_t partEnd =
+				  std::lower_bound(active + part, active + end, first + genomes) - active;
+
+				const int64_t survivors = updateBirds(m_birds,
+													  m_genomes,
+													  m_queries[first / genomes],
+													  m_bounds,
+													  m_distance,
+													  m_brains,
+													  part,
+													  partEnd,
+													  first,
+													  schedule);
+				std::copy_n(active + part, survivors, active + begin + alive);
+				std::copy_n(died + part, partEnd - part - survivors, died + begin + dead);
+				alive += survivors;
+				dead += partEnd - part - survivors;
+				part = partEnd;
+			}
+
+			m_workerBegin[worker] = begin;
+			m_workerAlive[worker] = alive;
+			m_workerDied[worker]  = dead;
+		});
+
+		// Join the survivors (and the dead) of every chunk back into a single list
+		m_birds.mergeActive(m_workerBegin, m_workerAlive);
+		m_birds.mergeDied(m_workerBegin, m_workerDied);
+		m_alive = m_birds.numActive();
+		++m_ticks;
+		++m_generationTicks;
+
+		// Steady-state birds are born partway through a course, so they can't be replayed
+		if (!m_steadyState) { m_replay.record(m_birds, m_brains.jump()); }
+
+		// Once the tick budget has run out, score the survivors on the distance so far
+		const int64_t budget  = effectiveTickBudget();
+		const bool outOfTicks = budget > 0 && m_generationTicks >= budget;
+		if (outOfTicks) {
+			if (!m_steadyState) { m_replay.recordSurvivors(m_birds); }
+			m_birds.killActive(m_distance);
+			m_alive = 0;
+		}
+
+		if (m_steadyState) {
+			if (outOfTicks) { restartCourses(); }
+			respawn();
+		}
+
+		return m_alive;
+	}
+
+	// Breed the next generation from the current one and reset the world
+	void nextGeneration() {
+		PROFILE_PHASE(Phase::Evolution);
+		m_replay.write(m_birds,
+					   m_generation + 1,
+					   m_courseSeed,
+					   m_genomes.population(),
+					   {m_decisionInterval, m_substeps});
+		++m_generation;
+
+		// Reset the walls before the birds, since they may collide with "ghost" walls
+		// and cause some strange bugs
+		resetCourses(m_fixedCourse ? m_courseSeed : m_random.next());
+
+		// Create the next generation of mutated bird brains
+		aggregateFitness(m_birds.fitnesses(), m_episodes, m_aggregation, m_fitness);
+		recordStats();
+		newGeneration(
+		  m_genomes, m_fitness, m_selector, m_mutation, m_mutationRate, m_pool, m_randoms);
+		m_parentFitness.assign(m_fitness.begin(), m_fitness.end());
+		m_birds.reset(m_bounds.height / 2);
+		m_brains.clearJumps();
+
+		m_alive				  = m_birds.size();
+		m_distance			  = 0;
+		m_generationTicks	  = 0;
+		m_generationStartTime = librapid::now();
+		std::fill(m_birthDistance.begin(), m_birthDistance.end(), 0.0);
+
+		saveCheckpointIfDue(m_generation - 1);
+	}
+
+	// Save a checkpoint every `interval` generations (0 = never), replacing the file each time
+	void setCheckpoints(const std::string &path, int64_t interval) {
+		m_checkpointPath	 = path;
+		m_checkpointInterval = interval;
+	}
+
+	// Start saving the current generation's genomes, along with everything else needed to carry on
+	// from the start of the generation, to a file. The file is written on a background thread
+	void saveCheckpoint(const std::string &path) {
+		auto topology = BirdBrain().topology();
+
+		CheckpointHeader header = createCheckpointHeader(
+		  m_genomes.population(), m_genomes.parameters(), topology.size(), m_randoms.size() + 1);
+		header.generation	= m_generation;
+		header.ticks		= m_ticks;
+		header.mutationRate = m_mutationRate;
+		header.courseSeed	= m_courseSeed;
+		header.fixedCourse	= m_fixedCourse;
+
+		// In steady state there is no previous generation, so the fitness pool stands in for it
+		m_checkpoint.save(path,
+						  header,
+						  topology,
+						  m_randoms,
+						  m_random,
+						  m_steadyState ? m_fitness : m_parentFitness,
+						  m_genomes.data().data(),
+						  m_genomes.scaleData().data());
+	}
+
+	// Append the jumps of the recorded birds (by default, just the elite) in every generation to a
+	// replay file (see replay.hpp). An empty path stops recording. Returns false if the file
+	// couldn't be opened
+	bool setReplayLog(const std::string &path) {
+		m_replay.clear();
+		if (path.empty()) {
+			m_replay.close();
+			return true;
+		}
+		return m_replay.open(path);
+	}
+
+	// Choose which birds' jumps are recorded
+	void setReplayBirds(const std::vector<int64_t> &birds) { m_replay.setBirds(birds); }
+
+	// Append the statistics of every generation to a telemetry file (see telemetry.hpp). An empty
+	// path stops recording. Returns false if the file couldn't be opened
+	bool setTelemetryLog(const std::string &path) {
+		if (path.empty()) {
+			m_telemetry.close();
+			return true;
+		}
+		return m_telemetry.open(path);
+	}
+
+	// Wait for the checkpoint being saved, if any, to be completely written
+	void waitForCheckpoint() { m_checkpoint.wait(); }
+
+	// Carry on from a checkpoint, restarting the generation it was saved in. The file is
+	// memory-mapped and the genomes copied straight out of it, so even a huge population loads
+	// almost instantly. The checkpoint must have the same population size and topology. Returns
+	// false if the checkpoint couldn't be loaded, in which case the simulation is unchanged
+	bool loadCheckpoint(const std::string &path) {
+		MappedFile file(path);
+		if (!file.valid() || file.size() < sizeof(CheckpointHeader)) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to read checkpoint '{}'\n", path);
+			return false;
+		}
+
+		CheckpointHeader header;
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		auto topology			 = BirdBrain().topology();
+		const char *error		 = nullptr;
+		const size_t genomeBytes = m_genomes.data().size() * sizeof(Gene);
+
+		if (header.magic != CheckpointHeader::expectedMagic) {
+			error = "it is not a checkpoint";
+		} else if (header.version != CheckpointHeader::currentVersion) {
+			error = "it was written by a different version";
+		} else if (header.geneSize != sizeof(Gene) ||
+				   header.population != m_genomes.population() ||
+				   header.parameters != m_genomes.parameters() ||
+				   header.layers != static_cast<int64_t>(topology.size())) {
+			error = "it is for a different population or brain";
+		} else if (header.randoms < 1 ||
+				   header.genomeOffset != checkpointGenomeOffset(header.layers,
+																 header.randoms,
+																 header.population) ||
+				   file.size() < header.genomeOffset + genomeBytes) {
+			error = "it is truncated";
+		}
+
+		const char *cursor = file.data() + sizeof(header);
+		for (int64_t i = 0; !error && i < header.layers; ++i) {
+			uint64_t nodes;
+			std::memcpy(&nodes, cursor + i * sizeof(nodes), sizeof(nodes));
+			if (nodes != topology[i]) { error = "it is for a different population or brain"; }
+		}
+
+		if (error) {
+			fmt::print(
+			  fmt::fg(fmt::color::red), "Unable to load checkpoint '{}': {}\n", path, error);
+			return false;
+		}
+
+		cursor += header.layers * sizeof(uint64_t);
+
+		// Restore the random streams. If the number of threads has changed, the run carries on
+		// from the same state but won't exactly match one that was never interrupted
+		const int64_t workers = header.randoms - 1;
+		std::memcpy(&m_random.state(),
+					cursor + workers * sizeof(Random::State),
+					sizeof(Random::State));
+
+		Random spare = m_random;
+		for (int64_t i = 0; i < static_cast<int64_t>(m_randoms.size()); ++i) {
+			if (i < workers) {
+				std::memcpy(&m_randoms[i].state(),
+							cursor + i * sizeof(Random::State),
+							sizeof(Random::State));
+			} else {
+				spare.jump();
+				m_randoms[i] = spare;
+			}
+		}
+
+		if (workers != static_cast<int64_t>(m_randoms.size())) {
+			fmt::print(fmt::fg(fmt::color::yellow),
+					   "Checkpoint '{}' was saved with {} thread(s), not {}.\n",
+					   path,
+					   workers,
+					   m_randoms.size());
+		}
+
+		cursor += header.randoms * sizeof(Random::State);
+
+		m_parentFitness.resize(header.population);
+		std::memcpy(m_parentFitness.data(), cursor, header.population * sizeof(double));
+		m_fitness.assign(m_parentFitness.begin(), m_parentFitness.end());
+		cursor += header.population * sizeof(double);
+
+		std::memcpy(m_genomes.scaleData().data(),
+					cursor,
+					m_genomes.scaleData().size() * sizeof(Scalar));
+		std::memcpy(m_genomes.data().data(), file.data() + header.genomeOffset, genomeBytes);
+
+		m_generation   = header.generation;
+		m_ticks		   = header.ticks;
+		m_mutationRate = static_cast<float>(header.mutationRate);
+		m_fixedCourse  = header.fixedCourse;
+
+		// Restart the generation from the beginning
+		m_replay.clear();
+		resetCourses(header.courseSeed);
+		m_birds.reset(m_bounds.height / 2);
+		m_brains.clearJumps();
+
+		m_alive				  = m_birds.size();
+		m_distance			  = 0;
+		m_generationTicks	  = 0;
+		m_generationStartTime = librapid::now();
+		m_statsStartTime	  = m_generationStartTime;
+		m_statsTicks		  = m_ticks;
+		std::fill(m_birthDistance.begin(), m_birthDistance.end(), 0.0);
+		return true;
+	}
+
+	// Send copies of the fittest `count` genomes of the generation that has just finished to
+	// another island. Call this before nextGeneration(). Returns the number of genomes sent
+	int64_t emigrate(MigrationQueue<Gene> &queue, int64_t count) {
+		aggregateFitness(m_birds.fitnesses(), m_episodes, m_aggregation, m_fitness);
+		const auto &fitness = m_fitness;
+		count				= std::min(count, m_genomes.population());
+
+		m_migrants.resize(m_genomes.population());
+		for (size_t i = 0; i < m_migrants.size(); ++i) { m_migrants[i] = i; }
+		std::partial_sort(m_migrants.begin(),
+						  m_migrants.begin() + count,
+						  m_migrants.end(),
+						  [&](int64_t a, int64_t b) { return fitness[a] > fitness[b]; });
+
+		int64_t sent = 0;
+		for (int64_t i = 0; i < count; ++i) {
+			const int64_t migrant = m_migrants[i];
+			sent += queue.push(m_genomes.row(migrant), m_genomes.scales(migrant), fitness[migrant]);
+		}
+		return sent;
+	}
+
+	// Replace birds in the new generation with any genomes that have arrived from another island.
+	// Call this after nextGeneration(). The elite in the first slot is never replaced. Returns the
+	// number of genomes received
+	int64_t immigrate(MigrationQueue<Gene> &queue) {
+		int64_t received = 0;
+		double fitness	 = 0;
+		for (int64_t i = m_genomes.population() - 1; i > 0; --i) {
+			if (!queue.pop(m_genomes.row(i), m_genomes.scales(i), fitness)) { break; }
+			++received;
+		}
+		return received;
+	}
+
+	[[nodiscard]] const WorldBounds &bounds() const { return m_bounds; }
+	// Replay the current course every generation instead of generating a new one
+	void setFixedCourse(bool fixed) { m_fixedCourse = fixed; }
+
+	// End each generation after `ticks` ticks (0 = only once every bird has died). In steady-state
+	// mode, this is how long each course lasts before the world is reset. Since the course would
+	// otherwise speed up forever, a budget of 0 falls back to STEADY_STATE_COURSE_TICKS there
+	void setTickBudget(int64_t ticks) { m_tickBudget = ticks; }
+
+	// Replace genomes as soon as their birds die, rather than a generation at a time. In this mode
+	// the dead are respawned before tick() returns, so it never returns 0 and nextGeneration() is
+	// never due; the generation counter instead goes up once for every population's worth of
+	// children. Anything that loops until tick() returns 0 has to use generational replacement
+	void setSteadyState(bool steadyState) { m_steadyState = steadyState; }
+
+	// Set the learning rate used to mutate this simulation's children
+	void setMutationRate(float rate) { m_mutationRate = rate; }
+
+	// Choose how the fitness values from each genome's episodes are combined
+	void setFitnessAggregation(FitnessAggregation aggregation) { m_aggregation = aggregation; }
+
+	// Choose the activation function of the brains' hidden layers
+	void setActivation(Activation activation) { m_brains.setActivation(activation); }
+
+	// Evaluate each bird's brain once every `ticks` ticks (at least 1), repeating its decision in
+	// between
+	void setDecisionInterval(int64_t ticks) { m_decisionInterval = std::max<int64_t>(ticks, 1); }
+
+	// Split the physics of every tick into `substeps` steps (at least 1)
+	void setSubsteps(int64_t substeps) { m_substeps = std::max<int64_t>(substeps, 1); }
+
+	[[nodiscard]] const WallRing &walls(int64_t episode = 0) const { return m_walls[episode]; }
+	[[nodiscard]] const Course &course(int64_t episode = 0) const { return m_courses[episode]; }
+	[[nodiscard]] bool fixedCourse() const { return m_fixedCourse; }
+	[[nodiscard]] int64_t episodes() const { return m_episodes; }
+	[[nodiscard]] FitnessAggregation fitnessAggregation() const { return m_aggregation; }
+	[[nodiscard]] float mutationRate() const { return m_mutationRate; }
+	[[nodiscard]] int64_t tickBudget() const { return m_tickBudget; }
+
+	// The tick budget actually in force, including steady state's default
+	[[nodiscard]] int64_t effectiveTickBudget() const {
+		return m_tickBudget == 0 && m_steadyState ? STEADY_STATE_COURSE_TICKS : m_tickBudget;
+	}
+	[[nodiscard]] bool steadyState() const { return m_steadyState; }
+	[[nodiscard]] Activation activation() const { return m_brains.activation(); }
+	[[nodiscard]] int64_t decisionInterval() const { return m_decisionInterval; }
+	[[nodiscard]] int64_t substeps() const { return m_substeps; }
+	[[nodiscard]] const ReplayRecorder &replay() const { return m_replay; }
+	[[nodiscard]] const TelemetryLog &telemetry() const { return m_telemetry; }
+	[[nodiscard]] const GenerationStats &lastStats() const { return m_lastStats; }
+	[[nodiscard]] const BirdPopulation &birds() const { return m_birds; }
+	[[nodiscard]] const WorldQuery &query(int64_t episode = 0) const { return m_queries[episode]; }
+	[[nodiscard]] const GenomeArena<Gene> &genomes() const { return m_genomes; }
+	[[nodiscard]] const MutationEngine &mutation() const { return m_mutation; }
+	MutationEngine &mutation() { return m_mutation; }
+	[[nodiscard]] const ParentSelector &selector() const { return m_selector; }
+	ParentSelector &selector() { return m_selector; }
+	[[nodiscard]] int64_t alive() const { return m_alive; }
+	[[nodiscard]] double distance() const { return m_distance; }
+	[[nodiscard]] int64_t generation() const { return m_generation; }
+	[[nodiscard]] int64_t ticks() const { return m_ticks; }
+	[[nodiscard]] int64_t threads() const { return m_pool.size(); }
+	[[nodiscard]] double generationStartTime() const { return m_generationStartTime; }
+
+private:
+	// Times the selector is rebuilt for every generation's worth of births in steady state
+	static constexpr int64_t selectionRefreshes = 16;
+
+	// Replace every genome whose birds have died in every episode with a child, and respawn its
+	// birds. The genome's fitness is how far its birds flew after they were born, combined over
+	// its episodes. Parents are chosen from the fitness pool, where each genome is scored by its
+	// last completed life, and a child inherits its parent's score until it has lived its own
+	void respawn() {
+		PROFILE_PHASE(Phase::Evolution);
+
+		// Only the genomes of the birds that died on this tick can have run out of birds, so only
+		// their other episodes need checking. Once the tick budget has run out, every bird is dead
+		const int64_t genomes = m_genomes.population();
+		m_respawn.clear();
+		if (m_birds.numActive() == 0) {
+			for (int64_t genome = 0; genome < genomes; ++genome) { m_respawn.push_back(genome); }
+		} else {
+			for (int64_t k = 0; k < m_birds.numDied(); ++k) {
+				const int64_t genome = m_birds.died()[k] % genomes;
+				if (m_checked[genome]) { continue; }
+				m_checked[genome] = 1;
+
+				uint8_t alive = 0;
+				for (int64_t episode = 0; episode < m_episodes; ++episode) {
+					alive |= m_birds.alive(episode * genomes + genome);
+				}
+				if (!alive) { m_respawn.push_back(genome); }
+			}
+
+			for (int64_t k = 0; k < m_birds.numDied(); ++k) {
+				m_checked[m_birds.died()[k] % genomes] = 0;
+			}
+
+			// The dead are listed episode by episode, so sort the genomes to list their birds in
+			// order when reviving them
+			std::sort(m_respawn.begin(), m_respawn.end());
+		}
+
+		if (m_respawn.empty()) { return; }
+
+		// Birds are killed with the square of the world's distance at the time, so take the root
+		// to find where they died
+		for (int64_t genome : m_respawn) {
+			double fitness = m_aggregation == FitnessAggregation::Min ? DBL_MAX : 0;
+			for (int64_t episode = 0; episode < m_episodes; ++episode) {
+				double life =
+				  std::sqrt(m_birds.fitness(episode * genomes + genome)) - m_birthDistance[genome];
+				if (m_aggregation == FitnessAggregation::Min) {
+					fitness = std::min(fitness, life * life);
+				} else {
+					fitness += life * life / static_cast<double>(m_episodes);
+				}
+			}
+			m_fitness[genome] = fitness;
+		}
+
+		// Rebuilding the selector's tables takes O(N) time (or O(N log N) for rank selection), so
+		// rather than on every tick with a death, they are only rebuilt a few times for every
+		// generation's worth of births. In between, parents are chosen with slightly stale weights
+		if (!m_selector.prepared() || m_selectionAge >= genomes / selectionRefreshes) {
+			m_selector.prepare(m_fitness);
+			m_selectionAge = 0;
+		}
+		m_selectionAge += m_respawn.size();
+
+		// Choose every parent before any child is written, breeding the children in the arena's
+		// back buffer (which is otherwise unused in steady state). A genome replaced on this tick
+		// can still be a parent, but its place is never taken by an unscored child first
+		m_inherited.clear();
+		for (int64_t genome : m_respawn) {
+			const int64_t parent = m_selector.select(m_random);
+			m_genomes.reproduce(parent, genome);
+			m_inherited.push_back(m_fitness[parent]);
+		}
+
+		// Mutate the children and move them into the empty slots
+		for (size_t i = 0; i < m_respawn.size(); ++i) {
+			const int64_t genome = m_respawn[i];
+			m_mutation.mutate(m_genomes.nextRow(genome),
+							  m_genomes.nextScales(genome),
+							  1,
+							  m_genomes.parameters(),
+							  m_mutationRate,
+							  m_random);
+			m_genomes.promote(genome);
+
+			m_fitness[genome]		= m_inherited[i];
+			m_birthDistance[genome] = m_distance;
+		}
+
+		// Respawn the children's birds in every episode. The list is built episode by episode, so
+		// it is already in order
+		m_revive.clear();
+		for (int64_t episode = 0; episode < m_episodes; ++episode) {
+			for (int64_t genome : m_respawn) { m_revive.push_back(episode * genomes + genome); }
+		}
+		m_birds.revive(m_revive, m_bounds.height / 2);
+		m_brains.clearJumps(m_revive);
+		m_alive = m_birds.numActive();
+
+		m_births += m_respawn.size();
+		const int64_t completed = m_births / genomes;
+		m_generation += completed;
+		m_births %= genomes;
+
+		// The fitness of the genomes just replaced stands in for the generation as a whole
+		if (completed > 0) {
+			recordStats();
+			saveCheckpointIfDue(m_generation - completed);
+		}
+	}
+
+	// Save a checkpoint if the generation counter has passed a multiple of the checkpoint interval
+	// since it was `previous`
+	void saveCheckpointIfDue(int64_t previous) {
+		if (m_checkpointInterval > 0 &&
+			m_generation / m_checkpointInterval != previous / m_checkpointInterval) {
+			saveCheckpoint(m_checkpointPath);
+		}
+	}
+
+	// Work out the statistics of the generation that has just finished from each genome's fitness,
+	// and append them to the telemetry log
+	void recordStats() {
+		const double now = librapid::now();
+
+		// Fitness is the square of a distance, so report the distance
+		m_ranked.resize(m_fitness.size());
+		double total = 0;
+		for (size_t i = 0; i < m_fitness.size(); ++i) {
+			m_ranked[i] = std::sqrt(m_fitness[i]);
+			total += m_ranked[i];
+		}
+		auto middle = m_ranked.begin() + m_ranked.size() / 2;
+		std::nth_element(m_ranked.begin(), middle, m_ranked.end());
+
+		GenerationStats &stats = m_lastStats;
+		stats.generation	   = static_cast<double>(m_generation);
+		stats.ticks			   = static_cast<double>(m_ticks - m_statsTicks);
+		stats.distance		   = m_distance;
+		stats.bestDistance	   = *std::max_element(middle, m_ranked.end());
+		stats.meanDistance	   = total / static_cast<double>(m_ranked.size());
+		stats.medianDistance   = *middle;
+		stats.seconds		   = now - m_statsStartTime;
+		stats.ticksPerSecond   = stats.seconds > 0 ? stats.ticks / stats.seconds : 0;
+		m_telemetry.push(stats);
+
+		m_statsTicks	 = m_ticks;
+		m_statsStartTime = now;
+	}
+
+	// Move every episode on to a new course (unless the course is fixed) and start it from the
+	// beginning, without touching the birds
+	void restartCourses() {
+		resetCourses(m_fixedCourse ? m_courseSeed : m_random.next());
+		m_distance		  = 0;
+		m_generationTicks = 0;
+	}
+
+	// Give every episode the course generated from a new seed, and put its walls back at the start
+	void resetCourses(uint64_t seed) {
+		m_courseSeed = seed;
+		for (int64_t i = 0; i < m_episodes; ++i) {
+			m_courses[i].reseed(episodeCourseSeed(seed, i));
+			resetWalls(m_walls[i], m_bounds, m_courses[i]);
+		}
+	}
+
+	WorldBounds m_bounds;
+	int64_t m_episodes;				   // Courses each genome is evaluated on
+	std::vector<WallRing> m_walls;	   // The walls of each episode
+	std::vector<Course> m_courses;	   // Where the gaps in each episode's walls are
+	std::vector<WorldQuery> m_queries; // Each episode's walls as seen by the birds on the last tick
+	uint64_t m_courseSeed = 0;		   // Seed the episodes' courses are generated from
+	bool m_fixedCourse	  = false;	   // Whether every generation uses the same courses
+
+	// How the fitness values from each genome's episodes are combined
+	FitnessAggregation m_aggregation = FitnessAggregation::Mean;
+
+	// Learning rate used to mutate the children. Each island has its own, so that changing it never
+	// touches another island's thread
+	float m_mutationRate = ::mutationRate;
+
+	int64_t m_tickBudget	   = 0;		// Ticks before a generation is cut short (0 = never)
+	bool m_steadyState		   = false; // Whether genomes are replaced as soon as they die
+	int64_t m_decisionInterval = 1;		// Ticks between each bird's decisions
+	int64_t m_substeps		   = 1;		// Physics steps in each tick
+
+	BirdPopulation m_birds;			  // Every genome's bird in every episode
+	GenomeArena<Gene> m_genomes;	  // The brain of every bird
+	PopulationBrain<Scalar> m_brains; // Evaluates the brains in batches
+	MutationEngine m_mutation;		  // Mutates the children each generation
+	ParentSelector m_selector;		  // Chooses the parents each generation
+	ReplayRecorder m_replay;		  // Records the jumps of a few birds each generation
+	TelemetryLog m_telemetry;		  // Records the statistics of every generation
+
+	ThreadPool m_pool;
+	std::vector<int64_t> m_workerBegin;	 // Start of each worker's chunk of the active list
+	std::vector<int64_t> m_workerAlive;	 // Birds alive in each worker's chunk
+	std::vector<int64_t> m_workerDied;	 // Birds that died in each worker's chunk
+	std::vector<int64_t> m_migrants;	 // Birds sorted by fitness when choosing emigrants
+	std::vector<double> m_fitness;		 // Fitness of each genome, combined over every episode
+	std::vector<double> m_parentFitness; // Fitness of the previous generation
+	std::vector<double> m_birthDistance; // Distance when each genome was born (steady state)
+	std::vector<int64_t> m_respawn;		 // Genomes being replaced on this tick (steady state)
+	std::vector<uint8_t> m_checked;		 // Genomes already checked for respawning on this tick
+	std::vector<int64_t> m_revive;		 // Birds being respawned on this tick (steady state)
+	std::vector<double> m_inherited;	 // Fitness each child inherits from its parent
+	std::vector<double> m_ranked;		 // Distance of each genome, partly sorted for the median
+	std::vector<Random> m_randoms;		 // One random stream per worker
+	Random m_random;					 // Random stream for the world (course seeds)
+
+	int64_t m_alive				 = 0; // Birds alive after the last tick
+	double m_distance			 = 0; // Distance travelled by the walls (used for fitness)
+	int64_t m_generation		 = 0; // Current generation number
+	int64_t m_ticks				 = 0; // Total ticks simulated across all generations
+	int64_t m_generationTicks	 = 0; // Ticks simulated in this generation
+	int64_t m_births			 = 0; // Children born towards the next generation (steady state)
+	int64_t m_selectionAge		 = 0; // Children born since the selector was last prepared
+	double m_generationStartTime = 0; // Time the generation started
+	int64_t m_statsTicks		 = 0; // Total ticks when the last statistics were recorded
+	double m_statsStartTime		 = 0; // Time the last statistics were recorded
+	GenerationStats m_lastStats {};	  // Statistics of the last generation to finish
+
+	// Saves checkpoints on a background thread, from its own copy of the genomes
+	CheckpointWriter m_checkpoint;
+	std::string m_checkpointPath;
+	int64_t m_checkpointInterval = 0; // Generations between checkpoints (0 = never)
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+// Runs the first island of an IslandModel on its own thread, so training never waits for a frame
+// to be drawn and a slow tick never drops frames. After a tick, once the render thread has taken
+// the last snapshot, the thread publishes a new WorldSnapshot through a TripleBuffer, which the
+// render thread reads with latest(). Changes from the interface are sent the other way with send(),
+// and are applied between ticks.
+//
+// By default the simulation is limited to one tick per displayed frame (60 per second), so that
+// training can be watched. With the limit removed, it runs as fast as the CPU allows however long
+// each frame takes to draw.
+//
+// The plotted histories are kept in TelemetryHistory buffers of a fixed size, and only the
+// downsampled points are copied into each snapshot, so neither the memory used nor the time spent
+// publishing and drawing them grows as the run goes on.
+class SimulationThread {
+public:
+	static constexpr double defaultTickRate	 = 60;
+	static constexpr int64_t historyInterval = 10;	// Ticks between points in the alive history
+	static constexpr int64_t plotPoints		 = 512; // Points in each plotted history
+
+	// The files the elite and the statistics of each generation are recorded to, when recording is
+	// turned on
+	static constexpr const char *replayPath	   = "replay.fbr";
+	static constexpr const char *telemetryPath = "telemetry.fbt";
+
+	explicit SimulationThread(IslandModel &islands) :
+			m_islands(islands), m_thread([this]() { run(); }) {}
+
+	SimulationThread(const SimulationThread &other)			   = delete;
+	SimulationThread &operator=(const SimulationThread &other) = delete;
+
+	~SimulationThread() { stop(); }
+
+	// Stop and join the simulation thread
+	void stop() {
+		m_running = false;
+		if (m_thread.joinable()) { m_thread.join(); }
+	}
+
+	// Queue a change to be applied before the next tick. Returns false if the queue is full
+	bool send(const Command &command) { return m_commands.push(command); }
+
+	// The most recently published snapshot. Only call this from the render thread
+	[[nodiscard]] const WorldSnapshot &latest() {
+		m_snapshots.update();
+		return m_snapshots.front();
+	}
+
+private:
+	void run() {
+		using Clock = std::chrono::steady_clock;
+
+		Simulation &simulation	 = m_islands.island(0);
+		auto nextTick			 = Clock::now();
+		auto rateStart			 = Clock::now();
+		int64_t rateTicks		 = 0;
+		double ticksPerSecond	 = 0;
+		double plottedGeneration = 0;
+
+		while (m_running.load(std::memory_order_relaxed)) {
+			applyCommands();
+
+			int64_t alive = m_islands.tick(0);
+
+			if (simulation.ticks() % historyInterval == 0) {
+				m_alive.push(simulation.distance(),
+							 static_cast<double>(alive) /
+							   static_cast<double>(simulation.birds().size()) * 100.0);
+			}
+
+			if (alive == 0) {
+				// All birds are dead, so start a new generation
+				double generationTime = librapid::now() - simulation.generationStartTime();
+
+				fmt::print(fmt::fg(fmt::color::orange_red) | fmt::emphasis::bold,
+						   "\n\nGeneration {} lasted {}.\n",
+						   simulation.generation() + 1,
+						   librapid::formatTime(generationTime));
+
+				m_islands.nextGeneration(0);
+				m_alive.clear();
+			}
+
+			// Plot each generation once it has finished. In steady state, this happens partway
+			// through a tick rather than when every bird has died, and the world's distance means
+			// nothing for the generation (see GenerationStats), so it isn't plotted
+			const GenerationStats &stats = simulation.lastStats();
+			if (stats.generation != plottedGeneration) {
+				if (!simulation.steadyState()) {
+					m_survival.push(stats.generation, stats.distance);
+				}
+				m_median.push(stats.generation, stats.medianDistance);
+				plottedGeneration = stats.generation;
+			}
+
+			// Measure the simulation speed about twice a second
+			++rateTicks;
+			auto now = Clock::now();
+			if (now - rateStart >= std::chrono::milliseconds(500)) {
+				ticksPerSecond = rateTicks / std::chrono::duration<double>(now - rateStart).count();
+				rateStart	   = now;
+				rateTicks	   = 0;
+			}
+
+			// Copying every bird takes O(N) time, so a new snapshot is only captured once the
+			// render thread has taken the last one. Any number of ticks can pass between frames,
+			// but at most one snapshot is captured for each
+			if (m_snapshots.taken()) {
+				WorldSnapshot &snapshot = m_snapshots.back();
+				snapshot.capture(simulation);
+				snapshot.ticksPerSecond = ticksPerSecond;
+				m_survival.update(snapshot.survivalGeneration, snapshot.survivalDistance);
+				m_median.update(snapshot.medianGeneration, snapshot.medianDistance);
+				m_alive.update(snapshot.aliveDistance, snapshot.alivePercent);
+				m_snapshots.publish();
+			}
+
+			// Wait for the next tick if the speed is limited. If the simulation falls behind, it
+			// carries on from now rather than trying to catch up
+			if (m_tickRate > 0) {
+				nextTick += std::chrono::duration_cast<Clock::duration>(
+				  std::chrono::duration<double>(1.0 / m_tickRate));
+				if (nextTick < Clock::now()) {
+					nextTick = Clock::now();
+				} else {
+					std::this_thread::sleep_until(nextTick);
+				}
+			}
+		}
+	}
+
+	// Apply every change sent by the interface since the last tick
+	void applyCommands() {
+		Command command {};
+		while (m_commands.pop(command)) {
+			switch (command.type) {
+				case Command::Type::SetMutationRate: {
+					// The other islands run on their own threads, so they are sent the change too
+					m_islands.island(0).setMutationRate(static_cast<float>(command.value));
+					for (int64_t i = 1; i < m_islands.size(); ++i) { m_islands.send(i, command); }
+					break;
+				}
+				case Command::Type::SetTickRate: {
+					m_tickRate = command.value;
+					break;
+				}
+				case Command::Type::SetTickBudget: {
+					m_islands.island(0).setTickBudget(static_cast<int64_t>(command.value));
+					break;
+				}
+				case Command::Type::SetSteadyState: {
+					m_islands.island(0).setSteadyState(command.value != 0);
+					break;
+				}
+				case Command::Type::SetRecordReplays: {
+					m_islands.island(0).setReplayLog(command.value != 0 ? replayPath : "");
+					break;
+				}
+				case Command::Type::SetDecisionInterval: {
+					m_islands.island(0).setDecisionInterval(static_cast<int64_t>(command.value));
+					break;
+				}
+				case Command::Type::SetSubsteps: {
+					m_islands.island(0).setSubsteps(static_cast<int64_t>(command.value));
+					break;
+				}
+				case Command::Type::SetRecordTelemetry: {
+					m_islands.island(0).setTelemetryLog(command.value != 0 ? telemetryPath : "");
+					break;
+				}
+			}
+		}
+	}
+
+	// A history being plotted, along with the points last downsampled from it. The history is only
+	// downsampled again once it has changed
+	struct PlottedHistory {
+		TelemetryHistory history;
+		std::vector<double> x;
+		std::vector<double> y;
+		uint64_t version = UINT64_MAX; // Version of the history the points were taken from
+
+		void push(double px, double py) { history.push(px, py); }
+		void clear() { history.clear(); }
+
+		// Copy the downsampled points into a snapshot's buffers
+		void update(std::vector<double> &outX, std::vector<double> &outY) {
+			if (version != history.version()) {
+				history.downsample(plotPoints, x, y);
+				version = history.version();
+			}
+			outX.assign(x.begin(), x.end());
+			outY.assign(y.begin(), y.end());
+		}
+	};
+
+	IslandModel &m_islands;
+	double m_tickRate = defaultTickRate; // Ticks per second, or 0 for no limit
+
+	PlottedHistory m_survival; // Distance survived by each generation
+	PlottedHistory m_median;   // Median genome distance of each generation
+	PlottedHistory m_alive;	   // Percentage of birds alive over the current generation
+
+	TripleBuffer<WorldSnapshot> m_snapshots;
+	CommandQueue m_commands;
+
+	std::atomic<bool> m_running {true};
+	std::thread m_thread; // Declared last, so it starts after everything it uses is constructed
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+// A copy of the parts of a bird population needed to draw it. It has the same accessors as
+// BirdPopulation, so the renderer can draw either one
+class BirdSnapshot {
+public:
+	// Copy the positions and states of the first `count` birds in a population
+	void capture(const BirdPopulation &birds, int64_t count) {
+		m_x		   = birds.x();
+		m_birdSize = birds.birdSize();
+		m_y.resize(count);
+		m_alive.resize(count);
+		for (int64_t i = 0; i < count; ++i) {
+			m_y[i]	   = static_cast<float>(birds.y(i));
+			m_alive[i] = birds.alive(i);
+		}
+	}
+
+	[[nodiscard]] int64_t size() const { return m_y.size(); }
+	[[nodiscard]] double x() const { return m_x; }
+	[[nodiscard]] const librapid::Vec2d &birdSize() const { return m_birdSize; }
+	[[nodiscard]] double y(int64_t index) const { return m_y[index]; }
+	[[nodiscard]] bool alive(int64_t index) const { return m_alive[index]; }
+
+private:
+	double m_x = 0;
+	librapid::Vec2d m_birdSize;
+	std::vector<float> m_y;
+	std::vector<uint8_t> m_alive;
+};
+
+// Everything the interface shows about a simulation at one moment. The simulation thread fills in
+// a snapshot after a tick whenever the last one has been drawn, and publishes it through a
+// TripleBuffer. The render thread only ever reads published snapshots, so drawing never touches the
+// live simulation.
+struct WorldSnapshot {
+	int64_t generation		   = 0;	// Generations completed
+	int64_t ticks			   = 0;	// Ticks simulated across every generation
+	int64_t alive			   = 0;	// Birds still alive in this generation, in every episode
+	int64_t population		   = 0;	// Birds in each generation, in every episode
+	double distance			   = 0;	// Distance travelled in this generation
+	double generationStartTime = 0;	// When this generation started
+	double ticksPerSecond	   = 0;	// Recent simulation speed
+
+	BirdSnapshot birds;
+	std::vector<Wall> walls;
+
+	// The plotted histories, downsampled to a fixed number of points (see TelemetryHistory)
+	std::vector<double> survivalGeneration; // Generation of each point in survivalDistance
+	std::vector<double> survivalDistance;	// Distance survived by each completed generation
+	std::vector<double> medianGeneration;	// Generation of each point in medianDistance
+	std::vector<double> medianDistance;		// Median genome distance of each completed generation
+	std::vector<double> aliveDistance;		// Distance at each point in alivePercent
+	std::vector<double> alivePercent;		// Percentage of birds alive over this generation
+
+	// Copy the current state of a simulation. Only the first episode is drawn, so only its birds
+	// and walls are copied. The buffers are reused, so this doesn't allocate once the snapshot has
+	// grown to its full size
+	void capture(const Simulation &simulation) {
+		generation			= simulation.generation();
+		ticks				= simulation.ticks();
+		alive				= simulation.alive();
+		population			= simulation.birds().size();
+		distance			= simulation.distance();
+		generationStartTime = simulation.generationStartTime();
+
+		birds.capture(simulation.birds(), simulation.genomes().population());
+
+		const WallRing &ring = simulation.walls();
+		walls.resize(ring.size());
+		for (int64_t i = 0; i < ring.size(); ++i) { walls[i] = ring[i]; }
+	}
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+// A neural network with a topology fixed at compile time, e.g.
+// StaticBrain<float, SigmoidActivation, 5, 8, 5, 1>.
+//
+// Every weight and bias lives inline in a single std::array, so a StaticBrain never allocates and
+// copying one is a plain memcpy. Since every layer size is a compile-time constant, the forward
+// pass is fully unrolled by the compiler. The weights of each layer are stored input-major ([input]
+// [output]), so each input is broadcast and multiplied into a whole row of outputs at once, which
+// maps directly onto SIMD lanes without needing any platform-specific intrinsics.
+//
+// The activation function is applied to every layer but the output layer, so forward() returns the
+// output layer's pre-activation, just like PopulationBrain. A bird jumps when it's above 0.
+template<typename Scalar, typename ActivationFunction, size_t... Nodes>
+class StaticBrain {
+public:
+	static constexpr size_t numLayers = sizeof...(Nodes);
+	static constexpr std::array<size_t, numLayers> nodes = {Nodes...};
+	static constexpr size_t numInputs					 = nodes.front();
+	static constexpr size_t numOutputs					 = nodes.back();
+
+	static_assert(numLayers >= 2, "A brain needs at least an input and an output layer");
+
+	// The offset of layer i's weights in the parameter array. Each layer's weights are followed
+	// immediately by its biases
+	static constexpr size_t weightOffset(size_t layer) {
+		size_t offset = 0;
+		for (size_t i = 0; i < layer; ++i) { offset += nodes[i] * nodes[i + 1] + nodes[i + 1]; }
+		return offset;
+	}
+
+	// The offset of layer i's biases in the parameter array
+	static constexpr size_t biasOffset(size_t layer) {
+		return weightOffset(layer) + nodes[layer] * nodes[layer + 1];
+	}
+
+	static constexpr size_t numParameters = weightOffset(numLayers - 1);
+
+	using Input		 = std::array<Scalar, numInputs>;
+	using Output	 = std::array<Scalar, numOutputs>;
+	using Parameters = std::array<Scalar, numParameters>;
+
+	StaticBrain()						  = default;
+	StaticBrain(const StaticBrain &other) = default;
+	StaticBrain(StaticBrain &&other)	  = default;
+
+	StaticBrain &operator=(const StaticBrain &other) = default;
+	StaticBrain &operator=(StaticBrain &&other)		 = default;
+
+	// Initialize every weight and bias with a random value between -1 and 1
+	void construct(Random &random) {
+		for (auto &parameter : m_parameters) { parameter = random.uniform(-1, 1); }
+	}
+
+	// Propagate an input vector through the neural network, returning the output layer's
+	// pre-activation
+	[[nodiscard]] Output forward(const Input &inputs) const {
+		Output output;
+		forwardLayer<0>(inputs.data(), output.data());
+		return output;
+	}
+
+	// Create an exact copy of a brain instance
+	StaticBrain copy() const { return *this; }
+
+	// Mutate the brain's weights and biases with a given probability (the learning rate).
+	// The learning rate is a value in the range [0, 1], and represents the probability that a given
+	// weight or bias value is mutated. When mutated, a value is changed to a new random value.
+	void mutate(double learningRate, Random &random) {
+		mutateReset(m_parameters.data(), numParameters, learningRate, random);
+	}
+
+	// The number of nodes in each layer, from the input layer to the output layer
+	[[nodiscard]] std::vector<size_t> topology() const { return {Nodes...}; }
+
+	// The weights of a layer, stored as an [input][output] matrix
+	[[nodiscard]] const Scalar *weights(size_t layer) const {
+		return m_parameters.data() + weightOffset(layer);
+	}
+
+	// The biases of a layer, one for each output
+	[[nodiscard]] const Scalar *biases(size_t layer) const {
+		return m_parameters.data() + biasOffset(layer);
+	}
+
+	[[nodiscard]] const Parameters &parameters() const { return m_parameters; }
+	Parameters &parameters() { return m_parameters; }
+
+private:
+	// Evaluate layer `Layer` and every layer after it, writing the network's output to `output`
+	template<size_t Layer>
+	void forwardLayer(const Scalar *input, Scalar *output) const {
+		constexpr size_t inputs	 = nodes[Layer];
+		constexpr size_t outputs = nodes[Layer + 1];
+
+		const Scalar *weight = m_parameters.data() + weightOffset(Layer);
+		const Scalar *bias	 = m_parameters.data() + biasOffset(Layer);
+
+		std::array<Scalar, outputs> result;
+		for (size_t o = 0; o < outputs; ++o) { result[o] = bias[o]; }
+
+		// Broadcast each input across every output
+		for (size_t i = 0; i < inputs; ++i) {
+			const Scalar x = input[i];
+			for (size_t o = 0; o < outputs; ++o) { result[o] += weight[i * outputs + o] * x; }
+		}
+
+		// Apply the activation function, except on the output layer
+		if constexpr (Layer + 2 < numLayers) {
+			for (size_t o = 0; o < outputs; ++o) {
+				result[o] = ActivationFunction::apply(result[o]);
+			}
+			forwardLayer<Layer + 1>(result.data(), output);
+		} else {
+			for (size_t o = 0; o < outputs; ++o) { output[o] = result[o]; }
+		}
+	}
+
+	alignas(32) Parameters m_parameters {};
+};
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <atomic>
+
+// Telemetry about a run, kept in two forms. For the plots, a TelemetryHistory holds a series of any
+// length in a fixed amount of memory, and downsamples it to a fixed number of points, so the cost
+// of drawing a plot doesn't grow however long the run goes on. For analysis, a TelemetryLog
+// appends the statistics of every generation to a file on a background thread, so nothing is ever
+// thrown away and the tick loop never waits for the disk.
+
+// Pick `points` of the given points that best preserve the shape of the line through them, using
+// Largest-Triangle-Three-Buckets. The first and last points are always kept, and the points in
+// between are split into equal buckets. From each bucket, the point forming the largest triangle
+// with the point chosen from the previous bucket and the average of the next bucket is kept.
+void downsampleLttb(const std::vector<double> &x, const std::vector<double> &y, int64_t points,
+					std::vector<double> &outX, std::vector<double> &outY) {
+	const int64_t count = static_cast<int64_t>(x.size());
+	if (points >= count || points < 3) {
+		outX.assign(x.begin(), x.end());
+		outY.assign(y.begin(), y.end());
+		return;
+	}
+
+	outX.resize(points);
+	outY.resize(points);
+	outX[0] = x[0];
+	outY[0] = y[0];
+
+	const double bucketSize = static_cast<double>(count - 2) / static_cast<double>(points - 2);
+	int64_t previous		= 0;
+	for (int64_t bucket = 0; bucket < points - 2; ++bucket) {
+		// The average of the next bucket (or the last point, for the last bucket)
+		const int64_t nextBegin = static_cast<int64_t>((bucket + 1) * bucketSize) + 1;
+		const int64_t nextEnd =
+		  std::min(static_cast<int64_t>((bucket + 2) * bucketSize) + 1, count);
+		double averageX = 0;
+		double averageY = 0;
+		for (int64_t i = nextBegin; i < nextEnd; ++i) {
+			averageX += x[i];
+			averageY += y[i];
+		}
+		averageX /= static_cast<double>(nextEnd - nextBegin);
+		averageY /= static_cast<double>(nextEnd - nextBegin);
+
+		const int64_t begin = static_cast<int64_t>(bucket * bucketSize) + 1;
+		const int64_t end	= nextBegin;
+		int64_t chosen		= begin;
+		double largest		= -1;
+		for (int64_t i = begin; i < end; ++i) {
+			const double area = std::abs((x[previous] - averageX) * (y[i] - y[previous]) -
+										 (x[previous] - x[i]) * (averageY - y[previous]));
+			if (area > largest) {
+				largest = area;
+				chosen	= i;
+			}
+		}
+
+		outX[bucket + 1] = x[chosen];
+		outY[bucket + 1] = y[chosen];
+		previous		 = chosen;
+	}
+
+	outX[points - 1] = x[count - 1];
+	outY[points - 1] = y[count - 1];
+}
+
+// A series of (x, y) points of any length, kept in a fixed number of buckets. Each bucket covers
+// the same number of consecutive points and remembers the lowest and highest of them. Once every
+// bucket is in use, neighbouring buckets are merged in pairs, so the buckets always span the whole
+// series at the finest resolution that fits. A short series is therefore kept exactly, and a long
+// one never loses a peak or a trough, however much it has been compacted.
+class TelemetryHistory {
+public:
+	static constexpr int64_t defaultBuckets = 1024;
+
+	explicit TelemetryHistory(int64_t buckets = defaultBuckets) :
+			m_capacity(std::max<int64_t>(buckets / 2 * 2, 2)) {
+		m_buckets.reserve(m_capacity);
+		m_x.reserve(2 * m_capacity);
+		m_y.reserve(2 * m_capacity);
+	}
+
+	// Add a point to the end of the series. The x values must not decrease
+	void push(double x, double y) {
+		++m_count;
+		++m_version;
+
+		if (!m_buckets.empty() && m_buckets.back().count < m_width) {
+			Bucket &bucket = m_buckets.back();
+			if (y < bucket.minY) { bucket.setMin(x, y); }
+			if (y > bucket.maxY) { bucket.setMax(x, y); }
+			++bucket.count;
+			return;
+		}
+
+		if (static_cast<int64_t>(m_buckets.size()) == m_capacity) { compact(); }
+		m_buckets.push_back({x, y, x, y, 1});
+	}
+
+	// Forget every point
+	void clear() {
+		m_buckets.clear();
+		m_width = 1;
+		m_count = 0;
+		++m_version;
+	}
+
+	// Write at most `points` points describing the whole series to `x` and `y`. Each bucket's
+	// lowest and highest points are listed in order, and then downsampled with LTTB
+	void downsample(int64_t points, std::vector<double> &x, std::vector<double> &y) {
+		m_x.clear();
+		m_y.clear();
+		for (const Bucket &bucket : m_buckets) {
+			const bool minFirst = bucket.minX <= bucket.maxX;
+			m_x.push_back(minFirst ? bucket.minX : bucket.maxX);
+			m_y.push_back(minFirst ? bucket.minY : bucket.maxY);
+			if (bucket.count > 1) {
+				m_x.push_back(minFirst ? bucket.maxX : bucket.minX);
+				m_y.push_back(minFirst ? bucket.maxY : bucket.minY);
+			}
+		}
+		downsampleLttb(m_x, m_y, points, x, y);
+	}
+
+	[[nodiscard]] int64_t count() const { return m_count; }
+	[[nodiscard]] int64_t width() const { return m_width; }
+
+	// Changes every time the series changes, so a reader can tell whether to downsample again
+	[[nodiscard]] uint64_t version() const { return m_version; }
+
+private:
+	struct Bucket {
+		double minX, minY; // The lowest point in the bucket
+		double maxX, maxY; // The highest point in the bucket
+		int64_t count;	   // Points added to the bucket
+
+		void setMin(double x, double y) {
+			minX = x;
+			minY = y;
+		}
+
+		void setMax(double x, double y) {
+			maxX = x;
+			maxY = y;
+		}
+	};
+
+	// Merge every pair of neighbouring buckets, halving the number in use and doubling the number
+	// of points each one covers
+	void compact() {
+		for (int64_t i = 0; i < m_capacity / 2; ++i) {
+			Bucket merged		 = m_buckets[2 * i];
+			const Bucket &second = m_buckets[2 * i + 1];
+			if (second.minY < merged.minY) { merged.setMin(second.minX, second.minY); }
+			if (second.maxY > merged.maxY) { merged.setMax(second.maxX, second.maxY); }
+			merged.count += second.count;
+			m_buckets[i] = merged;
+		}
+		m_buckets.resize(m_capacity / 2);
+		m_width *= 2;
+	}
+
+	int64_t m_capacity;			   // Maximum number of buckets (always even)
+	int64_t m_width	   = 1;		   // Points covered by each full bucket
+	int64_t m_count	   = 0;		   // Points added since the last clear
+	uint64_t m_version = 0;		   // Incremented on every change
+	std::vector<Bucket> m_buckets; // The buckets in use, in order
+
+	// Scratch space for the buckets' points when downsampling
+	std::vector<double> m_x;
+	std::vector<double> m_y;
+};
+
+// The statistics recorded for every generation. Every field is a double, so the log can store each
+// one as a column of doubles. The best, mean and median are of the distance each genome flew (the
+// square root of the fitness used for selection), combined over every episode as they are for
+// selection.
+//
+// In steady state, generations overlap and the world only restarts when every bird has died (or
+// the tick budget runs out), so `distance` is just how far the current course had got when the
+// generation's last child was born. It can't be compared between generations, so use the genome
+// distances instead.
+struct GenerationStats {
+	double generation;	   // Generations completed, including this one
+	double ticks;		   // Ticks the generation lasted
+	double distance;	   // Distance the generation survived (see above for steady state)
+	double bestDistance;   // Distance flown by the best genome
+	double meanDistance;   // Mean distance flown by every genome
+	double medianDistance; // Median distance flown by every genome
+	double seconds;		   // Time taken to simulate the generation (its turnover time)
+	double ticksPerSecond; // Simulation speed over the generation
+};
+
+static constexpr int64_t numTelemetryColumns = 8;
+
+static constexpr std::array<double GenerationStats::*, numTelemetryColumns> telemetryColumns = {
+  &GenerationStats::generation,
+  &GenerationStats::ticks,
+  &GenerationStats::distance,
+  &GenerationStats::bestDistance,
+  &GenerationStats::meanDistance,
+  &GenerationStats::medianDistance,
+  &GenerationStats::seconds,
+  &GenerationStats::ticksPerSecond};
+
+static constexpr std::array<const char *, numTelemetryColumns> telemetryColumnNames = {
+  "generation",
+  "ticks",
+  "distance",
+  "best_distance",
+  "mean_distance",
+  "median_distance",
+  "seconds",
+  "ticks_per_second"};
+
+// A telemetry file is a stream of blocks, each holding the statistics of a run of generations.
+// Every block is laid out as:
+//
+//   TelemetryBlockHeader
+//   double values[columns][rows]   Each column's values for every row, one column after another
+//
+// Storing each column contiguously keeps similar values together, so the file compresses well and
+// a single statistic can be read without touching the rest.
+struct TelemetryBlockHeader {
+	static constexpr std::array<char, 8> expectedMagic = {'F', 'B', 'A', 'I', 'T', 'L', 'M', 'Y'};
+	static constexpr uint32_t currentVersion			= 1;
+
+	std::array<char, 8> magic; // Identifies the start of a block
+	uint32_t version;		   // Format version. Bump this whenever the columns change
+	uint32_t columns;		   // Number of columns (numTelemetryColumns)
+	uint64_t rows;			   // Number of generations in the block
+};
+
+static_assert(std::is_trivially_copyable_v<TelemetryBlockHeader>);
+
+// Appends the statistics of every generation to a telemetry file. The simulation pushes each
+// generation's statistics into a fixed-size, lock-free ring of pending rows, and a background
+// thread writes whatever has arrived as a single block every so often. Pushing never allocates or
+// touches the disk. If the writer ever falls so far behind that the ring fills up, pushing waits
+// for it rather than dropping a generation.
+class TelemetryLog {
+public:
+	static constexpr int64_t capacity	= 4096;		 // Most generations waiting to be written
+	static constexpr size_t bufferBytes = 64 * 1024; // Size of the file's output buffer
+	static constexpr std::chrono::milliseconds flushInterval {100};
+
+	TelemetryLog() : m_pending(capacity) {}
+
+	TelemetryLog(const TelemetryLog &other)			   = delete;
+	TelemetryLog &operator=(const TelemetryLog &other) = delete;
+
+	~TelemetryLog() { close(); }
+
+	// Start appending to a file. Returns false if the file couldn't be opened
+	bool open(const std::string &path) {
+		close();
+		m_file = std::fopen(path.c_str(), "ab");
+		if (!m_file) {
+			fmt::print(fmt::fg(fmt::color::red), "Unable to write telemetry to '{}'\n", path);
+			return false;
+		}
+
+		// Allocate everything the writer needs up front, so it never allocates while the
+		// simulation is running (see allocations.hpp)
+		m_buffer.resize(bufferBytes);
+		std::setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+		m_columns.reserve(capacity * numTelemetryColumns);
+
+		m_running = true;
+		m_thread  = std::thread([this]() { run(); });
+		return true;
+	}
+
+	// Write everything pushed so far and close the file
+	void close() {
+		m_running = false;
+		if (m_thread.joinable()) { m_thread.join(); }
+		if (m_file) { std::fclose(m_file); }
+		m_file = nullptr;
+	}
+
+	// Queue a generation's statistics to be written. Only call this from one thread at a time
+	void push(const GenerationStats &stats) {
+		if (!m_file) { return; }
+
+		const int64_t tail = m_tail.load(std::memory_order_relaxed);
+		while (tail - m_head.load(std::memory_order_acquire) >= capacity) {
+			std::this_thread::yield();
+		}
+
+		m_pending[tail % capacity] = stats;
+		m_tail.store(tail + 1, std::memory_order_release);
+	}
+
+	[[nodiscard]] bool enabled() const { return m_file != nullptr; }
+
+private:
+	void run() {
+		while (true) {
+			// Check before writing, so everything pushed before close() is written
+			const bool running = m_running.load(std::memory_order_acquire);
+			writeBlock();
+			if (!running) { break; }
+			std::this_thread::sleep_for(flushInterval);
+		}
+	}
+
+	// Write every pending row as a single block
+	void writeBlock() {
+		const int64_t head = m_head.load(std::memory_order_relaxed);
+		const int64_t rows = m_tail.load(std::memory_order_acquire) - head;
+		if (rows == 0) { return; }
+
+		m_columns.resize(rows * numTelemetryColumns);
+		for (int64_t row = 0; row < rows; ++row) {
+			const GenerationStats &stats = m_pending[(head + row) % capacity];
+			for (int64_t column = 0; column < numTelemetryColumns; ++column) {
+				m_columns[column * rows + row] = stats.*telemetryColumns[column];
+			}
+		}
+		m_head.store(head + rows, std::memory_order_release);
+
+		TelemetryBlockHeader header {};
+		header.magic   = TelemetryBlockHeader::expectedMagic;
+		header.version = TelemetryBlockHeader::currentVersion;
+		header.columns = numTelemetryColumns;
+		header.rows	   = rows;
+
+		std::fwrite(&header, sizeof(header), 1, m_file);
+		std::fwrite(m_columns.data(), sizeof(double), m_columns.size(), m_file);
+		std::fflush(m_file);
+	}
+
+	std::FILE *m_file = nullptr;
+	std::vector<char> m_buffer;				// The file's output buffer
+	std::vector<GenerationStats> m_pending; // Rows waiting to be written
+	std::vector<double> m_columns;			// The rows being written, rearranged into columns
+
+	std::atomic<int64_t> m_head {0}; // Rows written so far (only changed by the writer)
+	std::atomic<int64_t> m_tail {0}; // Rows pushed so far (only changed by the simulation)
+
+	std::atomic<bool> m_running {false};
+	std::thread m_thread;
+};
+
+// Read every complete block from a telemetry file and return its rows in order. A block still
+// being written at the end of the file is ignored. Returns an empty list if the file couldn't be
+// read
+std::vector<GenerationStats> readTelemetry(const std::string &path) {
+	std::vector<GenerationStats> rows;
+
+	MappedFile file(path);
+	if (!file.valid()) {
+		fmt::print(fmt::fg(fmt::color::red), "Unable to read telemetry from '{}'\n", path);
+		return rows;
+	}
+
+	size_t offset = 0;
+	while (offset + sizeof(TelemetryBlockHeader) <= file.size()) {
+		TelemetryBlockHeader header;
+		std::memcpy(&header, file.data() + offset, sizeof(header));
+
+		if (header.magic != TelemetryBlockHeader::expectedMagic ||
+			header.version != TelemetryBlockHeader::currentVersion ||
+			header.columns != numTelemetryColumns) {
+			fmt::print(fmt::fg(fmt::color::red),
+					   "Telemetry file '{}' is corrupt after {} row(s)\n",
+					   path,
+					   rows.size());
+			break;
+		}
+
+		const size_t bytes = header.rows * numTelemetryColumns * sizeof(double);
+		if (offset + sizeof(header) + bytes > file.size()) { break; }
+
+		const char *columns = file.data() + offset + sizeof(header);
+		const size_t first	= rows.size();
+		rows.resize(first + header.rows);
+		for (int64_t column = 0; column < numTelemetryColumns; ++column) {
+			for (uint64_t row = 0; row < header.rows; ++row) {
+				std::memcpy(&(rows[first + row].*telemetryColumns[column]),
+							columns + (column * header.rows + row) * sizeof(double),
+							sizeof(double));
+			}
+		}
+		offset += sizeof(header) + bytes;
+	}
+
+	return rows;
+}
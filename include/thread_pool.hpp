@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// A fixed-size pool of worker threads for splitting the population into chunks. The calling thread
+// always takes part as worker 0, so a pool of one thread never starts any extra threads and simply
+// runs the work inline.
+//
+// Work is always split into the same contiguous chunks for a given size and thread count, so any
+// per-worker state (such as the random streams) is used identically from run to run.
+class ThreadPool {
+public:
+	explicit ThreadPool(int64_t numThreads) : m_numThreads(std::max<int64_t>(numThreads, 1)) {
+		for (int64_t worker = 1; worker < m_numThreads; ++worker) {
+			m_threads.emplace_back([this, worker]() { workerLoop(worker); });
+		}
+	}
+
+	ThreadPool(const ThreadPool &other)			   = delete;
+	ThreadPool &operator=(const ThreadPool &other) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_start.notify_all();
+		for (auto &thread : m_threads) { thread.join(); }
+	}
+
+	[[nodiscard]] int64_t size() const { return m_numThreads; }
+
+	// Split [0, count) into one contiguous chunk per worker and call func(begin, end, worker) for
+	// each of them, returning once every chunk has been processed
+	template<typename Func>
+	void parallelFor(int64_t count, Func &&func) {
+		const int64_t chunk = (count + m_numThreads - 1) / m_numThreads;
+
+		auto task = [&func, count, chunk](int64_t worker) {
+			int64_t begin = std::min(worker * chunk, count);
+			int64_t end	  = std::min(begin + chunk, count);
+			func(begin, end, worker);
+		};
+
+		if (m_numThreads == 1) {
+			task(0);
+			return;
+		}
+
+		// The task lives on this stack frame until every worker has finished with it, so it can be
+		// passed around as a plain pointer without any allocations
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_context	= &task;
+			m_invoke	= [](void *context, int64_t worker) {
+				   (*static_cast<decltype(task) *>(context))(worker);
+			};
+			m_remaining = m_numThreads - 1;
+			++m_generation;
+		}
+		m_start.notify_all();
+
+		task(0);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this]() { return m_remaining == 0; });
+	}
+
+private:
+	void workerLoop(int64_t worker) {
+		int64_t generation = 0;
+		while (true) {
+			void *context;
+			void (*invoke)(void *, int64_t);
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+				if (m_stop) return;
+				generation = m_generation;
+				context	   = m_context;
+				invoke	   = m_invoke;
+			}
+
+			invoke(context, worker);
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				--m_remaining;
+			}
+			m_done.notify_one();
+		}
+	}
+
+	int64_t m_numThreads;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_start; // Signalled when there is new work
+	std::condition_variable m_done;	 // Signalled when a worker finishes its chunk
+
+	void *m_context					 = nullptr; // The task currently being run
+	void (*m_invoke)(void *, int64_t) = nullptr; // Calls the task for a given worker
+	int64_t m_remaining				 = 0;		// Workers still running the current task
+	int64_t m_generation			 = 0;		// Incremented every time new work is submitted
+	bool m_stop						 = false;	// Set when the pool is destroyed
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+// Passes values from one writer thread to one reader thread without either of them ever waiting.
+// There are three buffers: the writer fills the back buffer, the reader reads the front buffer,
+// and the third sits in the middle holding the latest complete value. Publishing swaps the back
+// buffer with the middle one, and the reader swaps the middle buffer with the front one whenever a
+// newer value has been published, so the reader always sees the most recent complete value and
+// values it was too slow to read are simply skipped.
+//
+// The buffers are reused, so a value type which keeps its capacity (like std::vector) is never
+// reallocated once it has reached its full size.
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer &other)			   = delete;
+	TripleBuffer &operator=(const TripleBuffer &other) = delete;
+
+	// The buffer owned by the writer. Fill it, then call publish()
+	T &back() { return m_buffers[m_back]; }
+
+	// Make the back buffer the latest value, and take a new back buffer to write the next one into
+	void publish() {
+		m_back = m_middle.exchange(m_back | freshBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// Whether the reader has swapped in the last published value (or nothing has been published
+	// yet). The writer can check this to avoid filling a buffer that would never be read
+	[[nodiscard]] bool taken() const {
+		return (m_middle.load(std::memory_order_relaxed) & freshBit) == 0;
+	}
+
+	// Swap in the latest published value, if there is a new one. Returns true if front() changed
+	bool update() {
+		if ((m_middle.load(std::memory_order_relaxed) & freshBit) == 0) { return false; }
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+	// The buffer owned by the reader, holding the value swapped in by the last call to update()
+	[[nodiscard]] const T &front() const { return m_buffers[m_front]; }
+
+private:
+	static constexpr uint8_t indexMask = 0b011; // Index of the middle buffer
+	static constexpr uint8_t freshBit  = 0b100; // Set if the reader hasn't seen the middle buffer
+
+	std::array<T, 3> m_buffers;
+
+	// Each index is only touched by one thread, so they are kept on separate cache lines
+	alignas(64) uint8_t m_back = 0;
+	alignas(64) std::atomic<uint8_t> m_middle {1};
+	alignas(64) uint8_t m_front = 2;
+};
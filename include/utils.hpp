@@ -1,5 +1,12 @@
 #pragma once
 
+// The size of the world the birds and walls live in. The simulation only ever reads the world's
+// bounds from here, so it can run without a window (and therefore without surge) at all.
+struct WorldBounds {
+	double width;
+	double height;
+};
+
 // Returns true if two rectangles are intersecting. False otherwise.
 bool rectIntersection(const surge::Rectangle &a, const surge::Rectangle &b) {
 	double x1 = a.pos().x();
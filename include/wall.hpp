@@ -25,16 +25,16 @@ public:
 
 	Wall &operator=(Wall &&other) = default;
 
-	[[nodiscard]] WallRectangles rectangles() const {
+	[[nodiscard]] WallRectangles rectangles(double worldHeight) const {
 		// Return two Rectangle instances. The first is the upper portion of the wall; the second
-		// is the lower portion of the wall.
+		// is the lower portion of the wall, which extends down to the bottom of the world.
 
 		return WallRectangles {
 		  surge::Rectangle(m_position, m_size),
 		  surge::Rectangle(m_position.x(),
 						   m_position.y() + m_size.y() + m_gapHeight,
 						   m_size.x(),
-						   surge::window.height() - m_position.y() - m_size.y() - m_gapHeight)};
+						   worldHeight - m_position.y() - m_size.y() - m_gapHeight)};
 	}
 
 	[[nodiscard]] double gapHeight() const { return m_gapHeight; }
@@ -60,7 +60,7 @@ public:
 	}
 
 	void draw(surge::Color color = surge::Color::brown) const {
-		auto [upper, lower] = rectangles();
+		auto [upper, lower] = rectangles(surge::window.height());
 		upper.draw(color);
 		lower.draw(color);
 	}
@@ -74,10 +74,12 @@ private:
 	double m_timeScale;
 };
 
-// Create a new instance of a wall at a given position
-Wall createWall(double wallPosition, double wallSpeed = WALL_SPEED) {
+// Create a new instance of a wall at a given position. The gap is placed a fraction `gap` of the
+// way down the range it can be placed in (see Course)
+Wall createWall(const WorldBounds &bounds, double gap, double wallPosition,
+				double wallSpeed = WALL_SPEED) {
 	auto gapPosition =
-	  librapid::random<double>(WALL_BUFFER, surge::window.height() - WALL_GAP_SIZE - WALL_BUFFER);
+	  librapid::map(gap, 0, 1, WALL_BUFFER, bounds.height - WALL_GAP_SIZE - WALL_BUFFER);
 	return Wall(WALL_GAP_SIZE,
 				librapid::Vec2d(WALL_WIDTH, gapPosition),
 				librapid::Vec2d(wallPosition, 0),
@@ -86,44 +88,85 @@ Wall createWall(double wallPosition, double wallSpeed = WALL_SPEED) {
 				worldSpeed);
 }
 
-// Update the walls and draw them
-void updateWalls(std::vector<Wall> &walls) {
-	for (auto &wall : walls) {
-		wall.update();
-		wall.draw();
-
-		// To save memory, walls that have gone off the screen are recycled back to the far right
-		// of the screen. They're placed after the furthest wall with a gap between them to ensure
-		// the birds can actually make it through both consecutive gaps.
-		if (wall.position().x() < -WALL_WIDTH) {
-			// Find the furthest wall
-			int64_t furthestWallIndex	= 0;
-			double furthestWallDistance = 0;
-			for (int64_t i = 0; i < walls.size(); ++i) {
-				if (walls[i].position().x() > furthestWallDistance) {
-					furthestWallIndex	 = i;
-					furthestWallDistance = walls[i].position().x();
-				}
-			}
-
-			// As the walls move faster, the gap between them increases to accommodate for the
-			// decreased time between successive walls.
-
-			const auto &furthest = walls[furthestWallIndex];
-			double vel			 = furthest.velocity().x();
-			double space =
-			  WALL_SPACING + WALL_WIDTH * librapid::abs(vel) * WALL_SPEED_DISTANCE_COEFFICIENT;
-			wall = createWall(furthest.position().x() + space, vel);
+// The walls in the world, held in a ring buffer ordered from left to right. Every wall moves at
+// the same speed, so the leftmost wall is always the first to leave the screen. It is then recycled
+// as the new rightmost wall just by advancing the head of the ring, so no wall is ever searched
+// for. The gaps of new walls are read from a Course, in order.
+class WallRing {
+public:
+	WallRing() = default;
+
+	explicit WallRing(int64_t size) : m_walls(size) {}
+
+	// The i-th wall from the left
+	[[nodiscard]] const Wall &operator[](int64_t index) const { return m_walls[wrap(index)]; }
+	Wall &operator[](int64_t index) { return m_walls[wrap(index)]; }
+
+	[[nodiscard]] const Wall &front() const { return m_walls[m_head]; }
+	[[nodiscard]] const Wall &back() const { return (*this)[size() - 1]; }
+
+	[[nodiscard]] int64_t size() const { return m_walls.size(); }
+
+	// The number of walls created from the course so far, which is also the index into the course
+	// of the next wall's gap
+	[[nodiscard]] int64_t created() const { return m_created; }
+
+	// Replace the leftmost wall with a new one at a given position, making it the rightmost wall
+	void recycle(const WorldBounds &bounds, const Course &course, double position, double speed) {
+		m_walls[m_head] = createWall(bounds, course.gap(m_created++), position, speed);
+		m_head			= wrap(1);
+	}
+
+	// Re-create every wall from the start of a course, just off the right of the screen
+	void reset(const WorldBounds &bounds, const Course &course) {
+		m_head	  = 0;
+		m_created = 0;
+		for (auto &wall : m_walls) {
+			double position = bounds.width + WALL_SPACING * m_created;
+			wall			= createWall(bounds, course.gap(m_created++), position);
 		}
 	}
-}
 
-// Reset all the walls and re-create them just off the screen
-void resetWalls(std::vector<Wall> &walls) {
-	int64_t numWalls = walls.size();
-	walls.clear();
-	walls.reserve(numWalls);
-	for (int64_t i = 0; i < numWalls; ++i) {
-		walls.push_back(createWall(surge::window.width() + WALL_SPACING * i));
+private:
+	[[nodiscard]] int64_t wrap(int64_t index) const {
+		int64_t wrapped = m_head + index;
+		return wrapped < size() ? wrapped : wrapped - size();
 	}
+
+	std::vector<Wall> m_walls;
+	int64_t m_head	  = 0; // Index of the leftmost wall
+	int64_t m_created = 0; // Walls created from the course so far
+};
+
+// Update the walls. Nothing is drawn here, so this can be called without a window
+void updateWalls(WallRing &walls, const WorldBounds &bounds, const Course &course) {
+	for (int64_t i = 0; i < walls.size(); ++i) { walls[i].update(); }
+
+	// To save memory, walls that have gone off the screen are recycled back to the far right
+	// of the screen. They're placed after the furthest wall with a gap between them to ensure
+	// the birds can actually make it through both consecutive gaps.
+	while (walls.front().position().x() < -WALL_WIDTH) {
+		// As the walls move faster, the gap between them increases to accommodate for the
+		// decreased time between successive walls.
+
+		const auto &furthest = walls.back();
+		double vel			 = furthest.velocity().x();
+		double space =
+		  WALL_SPACING + WALL_WIDTH * librapid::abs(vel) * WALL_SPEED_DISTANCE_COEFFICIENT;
+		walls.recycle(bounds, course, furthest.position().x() + space, vel);
+	}
+}
+
+// Draw every wall to the current window
+void drawWalls(const std::vector<Wall> &walls) {
+	for (const auto &wall : walls) { wall.draw(); }
+}
+
+void drawWalls(const WallRing &walls) {
+	for (int64_t i = 0; i < walls.size(); ++i) { walls[i].draw(); }
+}
+
+// Reset all the walls and re-create them just off the screen, from the start of a course
+void resetWalls(WallRing &walls, const WorldBounds &bounds, const Course &course) {
+	walls.reset(bounds, course);
 }
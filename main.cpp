@@ -20,26 +20,37 @@ int main() {
 #endif
 
 	// Configure the window
-	surge::Window mainWindow(librapid::Vec2i(1000, 600), "Flappy Bird AI");
-
-	// Configure the walls
-	std::vector<Wall> walls(NUM_WALLS);
-	resetWalls(walls);
-
-	// The bird population
-	generationStartTime = librapid::now();
-	std::vector<Bird> birds(NUM_BIRDS);
-
-	// Configure each bird
-	for (auto &bird : birds) {
-		bird		 = createBird();
-		bird.brain() = createBirdBrain();
-	}
-
-	// Information about the generations and birds
-	std::vector<double> wallDistances;
-	std::vector<double> generationBirdsAlive;
-	std::vector<double> generationBirdsAliveDistance;
+	surge::Window mainWindow(librapid::Vec2i(WORLD_WIDTH, WORLD_HEIGHT), "Flappy Bird AI");
+
+	// The walls and bird population. The first island is the one drawn. With more than one island,
+	// the others evolve on background threads of their own
+	IslandModel islands(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT},
+						NUM_ISLANDS,
+						NUM_BIRDS,
+						RANDOM_SEED,
+						std::max<int64_t>(numThreads / NUM_ISLANDS, 1));
+	islands.start(1);
+
+	// The first island runs on its own thread, and everything drawn below comes from the latest
+	// snapshot it has published, so drawing never slows the simulation down
+	SimulationThread simulationThread(islands);
+	float learningRate	 = mutationRate;
+	bool limitSpeed		 = true;
+	bool steadyState	 = false;
+	int tickBudget		 = 0;
+	int decisionInterval = 1;
+	int substeps		 = 1;
+	bool recordTelemetry = false;
+
+	// Recorded runs are replayed here, on the render thread, so watching one never slows down
+	// training. While a replay is playing, it is drawn instead of the simulation
+	bool recordReplays = false;
+	std::unique_ptr<ReplayPlayer> replay;
+
+	// Draws the birds in a single batch. Only a sample of a large population needs to be drawn
+	BirdRenderer renderer(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT});
+	int renderMode = static_cast<int>(RenderMode::All);
+	int sampleSize = static_cast<int>(renderer.sampleSize());
 
 	// Style settings
 	surge::Font textFont("Arial", 20);
@@ -48,80 +59,208 @@ int main() {
 	ImGui::SetFont(textFont);
 	ImGui::GetStyle().WindowPadding = {16, 12};
 
+	// The time spent in each phase over the last few frames. Only used if the profiler is enabled
+	PhaseHistory phaseHistory(240);
+	PhaseTimes lastPhaseTimes = Profiler::instance().snapshot();
+	std::unique_ptr<ProfileLog> profileLog;
+	bool recordProfile = false;
+
 	// The main loop
 	while (!mainWindow.shouldClose()) {
 		// Begin a drawing and clear the screen
 		mainWindow.beginDrawing();
 		mainWindow.clear(surge::Color::veryDarkGray);
 
-		// Update the birds and walls
-		updateWalls(walls);
-		wallDistance += 0.1; // Arbitrary. So long as it's increasing, it's fine.
-		int64_t alive = updateBirds(birds, walls);
+		// Draw the latest state of the simulation
+		const WorldSnapshot &snapshot = simulationThread.latest();
+		int64_t alive				  = snapshot.alive;
+		double wallDistance			  = snapshot.distance;
+		{
+			PROFILE_PHASE(Phase::Drawing);
+			if (replay) {
+				// Hold the last frame once the bird has died
+				replay->step();
+				drawWalls(replay->walls());
+				renderer.draw(replay->birds());
+			} else {
+				drawWalls(snapshot.walls);
+				renderer.draw(snapshot.birds);
+			}
+		}
 
-		// Occasionally log some information about the current generation
+		// Occasionally log the number of birds still alive
 		if (mainWindow.frameCount() % 10 == 0) {
 			fmt::print(fmt::fg(fmt::color::purple) | fmt::emphasis::bold,
 					   "Alive: {:>7} / {:>7}\r",
 					   alive,
-					   NUM_BIRDS);
-			generationBirdsAlive.emplace_back(((double)alive / (double)NUM_BIRDS) * 100.0);
-			generationBirdsAliveDistance.emplace_back(wallDistance);
+					   snapshot.population);
 		}
 
-		if (alive == 0) {
-			// All birds are dead, so start a new generation
-			++generationNumber;
-			double generationTime = librapid::now() - generationStartTime;
+		mainWindow.drawFPS(librapid::Vec2i(20, 20));
+		mainWindow.drawFrameTime(librapid::Vec2i(20, 40));
+		mainWindow.drawTime(librapid::Vec2i(20, 60));
 
-			fmt::print(fmt::fg(fmt::color::orange_red) | fmt::emphasis::bold,
-					   "\n\nGeneration {} lasted {}.\n",
-					   generationNumber,
-					   librapid::formatTime(generationTime));
+		// Measure the time spent in each phase during the last frame
+		if (profilingEnabled) {
+			PhaseTimes phaseTimes = Profiler::instance().snapshot();
+			phaseHistory.push(phaseTimes - lastPhaseTimes);
+			if (profileLog) { profileLog->write(librapid::now(), phaseTimes - lastPhaseTimes); }
+			lastPhaseTimes = phaseTimes;
+		}
 
-			wallDistances.emplace_back(wallDistance);
+		if (ImGui::Begin("Statistics")) {
+			PROFILE_PHASE(Phase::Interface);
 
-			// Reset the walls before the birds, since they may collide with "ghost" walls
-			// and cause some strange bugs
-			resetWalls(walls);
+			ImGui::Text("%s", fmt::format("Generation: {}", snapshot.generation).c_str());
+			ImGui::Text("%s", fmt::format("Alive: {}", alive).c_str());
+			ImGui::Text("%s",
+						fmt::format("Time: {}",
+									librapid::formatTime(librapid::now() -
+														 snapshot.generationStartTime))
+						  .c_str());
 
-			// Create the next generation of mutated bird brains
-			std::vector<std::pair<Bird::BirdBrain, double>> birdBrains;
+			ImGui::Separator();
 
-			birdBrains.reserve(birds.size());
-			for (auto &bird : birds) { birdBrains.emplace_back(bird.brain(), bird.fitness()); }
+			ImGui::Text("%s",
+						fmt::format("Speed: {:.0f} ticks/s", snapshot.ticksPerSecond).c_str());
 
-			std::vector<Bird::BirdBrain> nextGeneration = newGeneration(birdBrains);
+			ImGui::Separator();
 
-			for (int64_t i = 0; i < NUM_BIRDS; ++i) {
-				birds[i]		 = createBird();
-				birds[i].brain() = nextGeneration[i];
+			// Changes are sent to the simulation thread rather than made here
+			if (ImGui::SliderFloat("Learning Rate", &learningRate, 0.0f, 0.2f)) {
+				simulationThread.send({Command::Type::SetMutationRate, learningRate});
+			}
+			if (ImGui::Checkbox("Limit Speed", &limitSpeed)) {
+				simulationThread.send(
+				  {Command::Type::SetTickRate, limitSpeed ? SimulationThread::defaultTickRate : 0});
+			}
+			// Islands only migrate between generations, which never end in steady state
+			if (islands.size() == 1 && ImGui::Checkbox("Steady State", &steadyState)) {
+				simulationThread.send({Command::Type::SetSteadyState, steadyState ? 1.0 : 0.0});
+			}
+			if (ImGui::SliderInt("Tick Budget", &tickBudget, 0, 20000)) {
+				simulationThread.send(
+				  {Command::Type::SetTickBudget, static_cast<double>(tickBudget)});
+			}
+			if (ImGui::SliderInt("Decision Interval", &decisionInterval, 1, 16)) {
+				simulationThread.send(
+				  {Command::Type::SetDecisionInterval, static_cast<double>(decisionInterval)});
+			}
+			if (ImGui::SliderInt("Physics Substeps", &substeps, 1, 8)) {
+				simulationThread.send({Command::Type::SetSubsteps, static_cast<double>(substeps)});
 			}
 
-			generationBirdsAlive.clear();
-			generationBirdsAliveDistance.clear();
+			ImGui::Separator();
 
-			wallDistance		= 0;
-			generationStartTime = librapid::now();
-		}
+			// Record the elite of every generation, and watch the most recent one again
+			if (ImGui::Checkbox("Record Replays", &recordReplays)) {
+				simulationThread.send({Command::Type::SetRecordReplays, recordReplays ? 1.0 : 0.0});
+			}
+			if (ImGui::Checkbox("Record Telemetry", &recordTelemetry)) {
+				simulationThread.send(
+				  {Command::Type::SetRecordTelemetry, recordTelemetry ? 1.0 : 0.0});
+			}
+			if (replay) {
+				const ReplayHeader &header = replay->record().header;
+				ImGui::Text("%s",
+							fmt::format("Replaying generation {}: {:.1f} / {:.1f}",
+										header.generation,
+										replay->distance(),
+										header.distance)
+							  .c_str());
+				if (ImGui::Button("Stop Replay")) { replay = nullptr; }
+			} else if (ImGui::Button("Watch Last Replay")) {
+				auto records = readReplays(SimulationThread::replayPath);
+				if (!records.empty()) {
+					replay = std::make_unique<ReplayPlayer>(WorldBounds {WORLD_WIDTH, WORLD_HEIGHT},
+															std::move(records.back()));
+				}
+			}
 
-		mainWindow.drawFPS(librapid::Vec2i(20, 20));
-		mainWindow.drawFrameTime(librapid::Vec2i(20, 40));
-		mainWindow.drawTime(librapid::Vec2i(20, 60));
+			ImGui::Separator();
 
-		if (ImGui::Begin("Statistics")) {
-			ImGui::Text("%s", fmt::format("Generation: {}", generationNumber).c_str());
-			ImGui::Text("%s", fmt::format("Alive: {}", alive).c_str());
-			ImGui::Text(
-			  "%s",
-			  fmt::format("Time: {}", librapid::formatTime(librapid::now() - generationStartTime))
-				.c_str());
+			// Choose how much of the population is drawn
+			if (ImGui::Combo("Birds Drawn",
+							 &renderMode,
+							 renderModeNames.data(),
+							 static_cast<int>(renderModeNames.size()))) {
+				renderer.setMode(static_cast<RenderMode>(renderMode));
+			}
+			if (renderer.mode() == RenderMode::Sample &&
+				ImGui::SliderInt("Sample Size", &sampleSize, 1, 5000)) {
+				renderer.setSampleSize(sampleSize);
+			}
+			ImGui::Text("%s", fmt::format("Quads Drawn: {}", renderer.quads()).c_str());
 
 			ImGui::Separator();
 
-			ImGui::SliderFloat("Learning Rate", &mutationRate, 0.0f, 0.2f);
+			// Show how every island is doing
+			if (islands.size() > 1 && ImGui::BeginTable("Islands", 5)) {
+				ImGui::TableSetupColumn("Island");
+				ImGui::TableSetupColumn("Generation");
+				ImGui::TableSetupColumn("Last");
+				ImGui::TableSetupColumn("Best");
+				ImGui::TableSetupColumn("Migrants In/Out");
+				ImGui::TableHeadersRow();
+
+				double bestDistance = 0;
+				for (int64_t i = 0; i < islands.size(); ++i) {
+					IslandSummary summary = islands.summary(i);
+					bestDistance		  = std::max(bestDistance, summary.bestDistance);
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", fmt::format("{}", i).c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", fmt::format("{}", summary.generation).c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", fmt::format("{:.1f}", summary.lastDistance).c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", fmt::format("{:.1f}", summary.bestDistance).c_str());
+					ImGui::TableNextColumn();
+					ImGui::Text(
+					  "%s",
+					  fmt::format("{} / {}", summary.migrantsIn, summary.migrantsOut).c_str());
+				}
+				ImGui::EndTable();
 
-			ImGui::Separator();
+				ImGui::Text("%s", fmt::format("Best Distance: {:.1f}", bestDistance).c_str());
+				ImGui::Separator();
+			}
+
+			// Show where the time goes in each frame, with each phase stacked on the last
+			if (profilingEnabled && ImGui::CollapsingHeader("Profiler")) {
+				for (int64_t i = 0; i < numPhases; ++i) {
+					ImGui::Text(
+					  "%s",
+					  fmt::format("{}: {:.3f} ms", phaseNames[i], phaseHistory.average(i)).c_str());
+				}
+
+				if (ImGui::Checkbox("Record to profile.csv", &recordProfile)) {
+					profileLog =
+					  recordProfile ? std::make_unique<ProfileLog>("profile.csv") : nullptr;
+				}
+
+				if (ImPlot::BeginPlot("Frame Breakdown", ImVec2(-1, 200))) {
+					ImPlot::SetupAxes(
+					  "Frame", "Time/ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+					// The history is a ring, so start plotting from its oldest frame
+					const auto &frames = phaseHistory.frames();
+					for (int64_t i = 0; i < numPhases; ++i) {
+						ImPlot::PlotShaded(phaseNames[i],
+										   frames.data(),
+										   phaseHistory.stacked(i).data(),
+										   phaseHistory.stacked(i + 1).data(),
+										   static_cast<int>(phaseHistory.size()),
+										   0,
+										   static_cast<int>(phaseHistory.offset()));
+					}
+					ImPlot::EndPlot();
+				}
+
+				ImGui::Separator();
+			}
 
 			ImGui::PushFont(mathFont);
 			if (ImPlot::BeginSubplots("", 2, 1, ImVec2(-1, -1))) {
@@ -130,8 +269,7 @@ int main() {
 					ImPlot::SetupAxis(ImAxis_X1, "Time/s");
 					ImPlot::SetupAxis(ImAxis_Y1, "Alive %");
 
-					ImPlot::PlotLine(
-					  "Birds Alive", generationBirdsAliveDistance, generationBirdsAlive);
+					ImPlot::PlotLine("Birds Alive", snapshot.aliveDistance, snapshot.alivePercent);
 					ImPlot::EndPlot();
 				}
 
@@ -139,7 +277,10 @@ int main() {
 					ImPlot::SetupAxis(ImAxis_X1, "Generation", ImPlotAxisFlags_AutoFit);
 					ImPlot::SetupAxis(ImAxis_Y1, "Distance", ImPlotAxisFlags_AutoFit);
 
-					ImPlot::PlotLine("Survival Distance", wallDistances);
+					ImPlot::PlotLine(
+					  "Survival Distance", snapshot.survivalGeneration, snapshot.survivalDistance);
+					ImPlot::PlotLine(
+					  "Median Distance", snapshot.medianGeneration, snapshot.medianDistance);
 					ImPlot::PlotInfLines(
 					  "Current Distance", &wallDistance, 1, ImPlotInfLinesFlags_Horizontal);
 					ImPlot::EndPlot();